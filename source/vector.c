@@ -1,17 +1,62 @@
-#include "vector.h"
+#include "vector_internal.h"
 #include <string.h>
 
-typedef struct
+static void vector_type_vector_destroy(void *item)
 {
-    size_t cap;   /* total capacity */
-    size_t len;   /* current length */
-    size_t tsize; /* type size*/
-    allocator_t *a; /* allocator pointer */
-} vector_header_t;
+    if (*(void **)item)
+        vector_free(*(void **)item);
+}
+
+static void vector_type_vector_copy(void *dst, const void *src)
+{
+    *(void **)dst = *(void *const *)src ? vector_share(*(void *const *)src) : NULL;
+}
+
+const vector_type_t vector_type_vector = {sizeof(void *), vector_type_vector_destroy, vector_type_vector_copy, NULL};
 
-typedef unsigned char byte_t;
+/* Destroy n elements starting at items, nothing to do for plain bytes */
+void internal_vector_destroy_range(const vector_type_t *type, void *items, size_t n, size_t tsize)
+{
+    size_t i;
+    if (!type || !type->destroy)
+        return;
+    for (i = 0; i < n; i++)
+        type->destroy((byte_t *)items + i * tsize);
+}
 
-#define VECTOR_HEADER(vector) ((vector_header_t *)((byte_t *)vector - sizeof(vector_header_t)))
+/* Relocate n elements from src to dst, ranges may overlap */
+void internal_vector_move_range(const vector_type_t *type, void *dst, void *src, size_t n, size_t tsize)
+{
+    size_t i;
+    if (!type || !type->move)
+    {
+        memmove(dst, src, n * tsize);
+        return;
+    }
+    if ((byte_t *)dst < (byte_t *)src)
+    {
+        for (i = 0; i < n; i++)
+            type->move((byte_t *)dst + i * tsize, (byte_t *)src + i * tsize);
+    }
+    else
+    {
+        for (i = n; i-- > 0;)
+            type->move((byte_t *)dst + i * tsize, (byte_t *)src + i * tsize);
+    }
+}
+
+/* Duplicate n elements from src into raw memory at dst */
+static void vector_copy_range(const vector_type_t *type, void *dst, const void *src, size_t n, size_t tsize)
+{
+    size_t i;
+    if (!type || !type->copy)
+    {
+        memcpy(dst, src, n * tsize);
+        return;
+    }
+    for (i = 0; i < n; i++)
+        type->copy((byte_t *)dst + i * tsize, (const byte_t *)src + i * tsize);
+}
 
 /* Initialize a new vector */
 void *vector_init(size_t tsize, size_t cap, allocator_t *a)
@@ -21,16 +66,139 @@ void *vector_init(size_t tsize, size_t cap, allocator_t *a)
         VECTOR_DEBUG_PERROR("Vector Init: given null allocator.\n");
         return NULL;
     }
-    vector_header_t h = {cap, 0, tsize, a};
-    void *ret = a->malloc(sizeof(h) + tsize * cap);
-    if (!ret)
+    vector_header_t *hdr = a->malloc(sizeof(vector_header_t) + tsize * cap);
+    if (!hdr)
     {
         VECTOR_DEBUG_PERROR("Vector Init: allocation failed.\n");
         return NULL;
     }
-    vector_header_t *hdr = ret;
-    *hdr = h;
-    return (byte_t *)ret + sizeof(h);
+    internal_vector_header_init(hdr, tsize, cap, a);
+    return (byte_t *)hdr + sizeof(vector_header_t);
+}
+
+/* Initialize a new vector whose elements start on an align byte boundary */
+void *vector_init_aligned(size_t tsize, size_t cap, size_t align, allocator_t *a)
+{
+    if (!a)
+    {
+        VECTOR_DEBUG_PERROR("Vector Init Aligned: given null allocator.\n");
+        return NULL;
+    }
+    if (align == 0 || (align & (align - 1)) || align > 0x80000000u)
+    {
+        VECTOR_DEBUG_PERROR("Vector Init Aligned: alignment is not a power of two.\n");
+        return NULL;
+    }
+    byte_t *raw = a->malloc(align - 1 + sizeof(vector_header_t) + tsize * cap);
+    if (!raw)
+    {
+        VECTOR_DEBUG_PERROR("Vector Init Aligned: allocation failed.\n");
+        return NULL;
+    }
+    byte_t *items = raw + sizeof(vector_header_t);
+    items += (align - (uintptr_t)items % align) % align;
+    vector_header_t *hdr = VECTOR_HEADER(items);
+    internal_vector_header_init(hdr, tsize, cap, a);
+    hdr->offset = (uint32_t)((byte_t *)hdr - raw);
+    hdr->align = (uint32_t)align;
+    return items;
+}
+
+/* Initialize a new vector whose elements follow lifecycle hooks */
+void *vector_init_typed(const vector_type_t *type, size_t cap, allocator_t *a)
+{
+    if (!type)
+    {
+        VECTOR_DEBUG_PERROR("Vector Init Typed: given null type.\n");
+        return NULL;
+    }
+    if (type->destroy && !type->copy)
+    {
+        VECTOR_DEBUG_PERROR("Vector Init Typed: destroy hook given without a copy hook.\n");
+        return NULL;
+    }
+    void *vector = vector_init(type->tsize, cap, a);
+    if (!vector)
+        return NULL;
+    VECTOR_HEADER(vector)->type = type;
+    return vector;
+}
+
+static int vector_is_shared(vector_header_t *hdr)
+{
+    return VECTOR_IS_SHARED(hdr);
+}
+
+/* Private copy of a shared vector with room for cap elements, drops one reference to the original */
+static void *vector_unshare(void *vector, size_t cap)
+{
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    size_t len = hdr->len < cap ? hdr->len : cap;
+    void *copy = hdr->align ? vector_init_aligned(hdr->tsize, cap, hdr->align, hdr->a)
+                            : vector_init(hdr->tsize, cap, hdr->a);
+    if (!copy)
+    {
+        VECTOR_DEBUG_PERROR("Vector Unshare: allocation failed.\n");
+        return NULL;
+    }
+    VECTOR_HEADER(copy)->type = hdr->type;
+    if (vector_is_shared(hdr))
+    {
+        vector_copy_range(hdr->type, copy, vector, len, hdr->tsize);
+    }
+    else
+    {
+        /* Sole owner: the elements change address, not owner */
+        internal_vector_destroy_range(hdr->type, (byte_t *)vector + len * hdr->tsize, hdr->len - len, hdr->tsize);
+        internal_vector_move_range(hdr->type, copy, vector, len, hdr->tsize);
+        hdr->len = 0;
+    }
+    VECTOR_HEADER(copy)->len = len;
+    vector_free(vector);
+    return copy;
+}
+
+/* Add an owner */
+void *vector_share(void *vector)
+{
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector Share: given null vector.\n");
+        return NULL;
+    }
+    atomic_fetch_add_explicit(&VECTOR_HEADER(vector)->refs, 1, memory_order_relaxed);
+    return vector;
+}
+
+/* Copy the buffer if other owners can see it */
+void *vector_make_unique(void *vector)
+{
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector Make Unique: given null vector.\n");
+        return NULL;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    if (!vector_is_shared(hdr))
+        return vector;
+    return vector_unshare(vector, hdr->cap);
+}
+
+/* Get the number of owners */
+vector_status_t vector_get_refs(void *vector, size_t *out)
+{
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector Get Refs: given null vector.\n");
+        return VEC_ERR;
+    }
+    if (!out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Get Refs: given null output pointer.\n");
+        return VEC_ERR;
+    }
+    *out = atomic_load_explicit(&VECTOR_HEADER(vector)->refs, memory_order_acquire);
+    return VEC_OK;
 }
 
 /* Free a vector */
@@ -47,7 +215,11 @@ vector_status_t vector_free(void *vector)
         VECTOR_DEBUG_PERROR("Vector Free: null allocator in header.\n");
         return VEC_ERR;
     }
-    hdr->a->free(hdr);
+    /* The last owner frees, acq_rel orders every owner's reads before it */
+    if (atomic_fetch_sub_explicit(&hdr->refs, 1, memory_order_acq_rel) > 1)
+        return VEC_OK;
+    internal_vector_destroy_range(hdr->type, vector, hdr->len, hdr->tsize);
+    hdr->a->free((byte_t *)hdr - hdr->offset);
     return VEC_OK;
 }
 
@@ -114,13 +286,19 @@ vector_status_t vector_remove(void *vector, size_t index)
         VECTOR_DEBUG_PERROR("Vector Remove: index out of bounds.\n");
         return VEC_INDEX_OOB;
     }
+    if (vector_is_shared(hdr))
+    {
+        VECTOR_DEBUG_PERROR("Vector Remove: vector is shared, call vector_unique first.\n");
+        return VEC_SHARED;
+    }
 
+    internal_vector_destroy_range(hdr->type, (byte_t *)vector + hdr->tsize * index, 1, hdr->tsize);
     if (hdr->len > 1 && index != hdr->len - 1)
     {
         /* Move entire tail of the array backward one space */
-        memmove((byte_t *)vector + hdr->tsize * index,
-                (byte_t *)vector + hdr->tsize * (index + 1),
-                (hdr->len - index - 1) * hdr->tsize);
+        internal_vector_move_range(hdr->type, (byte_t *)vector + hdr->tsize * index,
+                          (byte_t *)vector + hdr->tsize * (index + 1),
+                          hdr->len - index - 1, hdr->tsize);
     }
 
     hdr->len--;
@@ -142,12 +320,18 @@ vector_status_t vector_remove_ordered(void *vector, size_t index)
         VECTOR_DEBUG_PERROR("Vector Remove Ordered: index out of bounds.\n");
         return VEC_INDEX_OOB;
     }
+    if (vector_is_shared(hdr))
+    {
+        VECTOR_DEBUG_PERROR("Vector Remove Ordered: vector is shared, call vector_unique first.\n");
+        return VEC_SHARED;
+    }
 
+    internal_vector_destroy_range(hdr->type, (byte_t *)vector + hdr->tsize * index, 1, hdr->tsize);
     if (hdr->len > 1 && index != hdr->len - 1)
     {
-        memmove((byte_t *)vector + hdr->tsize * index,
-                (byte_t *)vector + hdr->tsize * (index + 1),
-                hdr->tsize);
+        internal_vector_move_range(hdr->type, (byte_t *)vector + hdr->tsize * index,
+                          (byte_t *)vector + hdr->tsize * (index + 1),
+                          hdr->len - index - 1, hdr->tsize);
     }
 
     hdr->len--;
@@ -200,10 +384,154 @@ void *vector_normal_copy(void *vector, void *(*malloc_fn)(size_t))
         return NULL;
     }
 
-    memcpy(raw, vector, total_size);
+    vector_copy_range(hdr->type, raw, vector, hdr->len, hdr->tsize);
     return raw;
 }
 
+/* Copy of a vector sized to its length, header and elements in one pass */
+void *vector_clone(void *vector)
+{
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector Clone: given null vector.\n");
+        return NULL;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    size_t bytes = hdr->len * hdr->tsize;
+    void *copy;
+    if (hdr->align)
+    {
+        copy = vector_init_aligned(hdr->tsize, hdr->len, hdr->align, hdr->a);
+        if (!copy)
+        {
+            VECTOR_DEBUG_PERROR("Vector Clone: allocation failed.\n");
+            return NULL;
+        }
+        VECTOR_HEADER(copy)->type = hdr->type;
+        VECTOR_HEADER(copy)->len = hdr->len;
+        vector_copy_range(hdr->type, copy, vector, hdr->len, hdr->tsize);
+        return copy;
+    }
+    vector_header_t *new_hdr = hdr->a->malloc(sizeof(vector_header_t) + bytes);
+    if (!new_hdr)
+    {
+        VECTOR_DEBUG_PERROR("Vector Clone: allocation failed.\n");
+        return NULL;
+    }
+    copy = (byte_t *)new_hdr + sizeof(vector_header_t);
+    if (hdr->type && hdr->type->copy)
+    {
+        memcpy(new_hdr, hdr, sizeof(vector_header_t));
+        vector_copy_range(hdr->type, copy, vector, hdr->len, hdr->tsize);
+    }
+    else
+    {
+        memcpy(new_hdr, hdr, sizeof(vector_header_t) + bytes);
+    }
+    new_hdr->cap = hdr->len;
+    atomic_init(&new_hdr->refs, 1);
+    return copy;
+}
+
+/* Join n vectors into a new one with a single allocation */
+void *vector_concat(void **vectors, size_t n)
+{
+    if (!vectors || n == 0 || !vectors[0])
+    {
+        VECTOR_DEBUG_PERROR("Vector Concat: given null or empty vector list.\n");
+        return NULL;
+    }
+    vector_header_t *first = VECTOR_HEADER(vectors[0]);
+    size_t total = 0, i;
+    for (i = 0; i < n; i++)
+    {
+        if (!vectors[i])
+        {
+            VECTOR_DEBUG_PERROR("Vector Concat: given null vector.\n");
+            return NULL;
+        }
+        if (VECTOR_HEADER(vectors[i])->tsize != first->tsize || VECTOR_HEADER(vectors[i])->type != first->type)
+        {
+            VECTOR_DEBUG_PERROR("Vector Concat: element type mismatch.\n");
+            return NULL;
+        }
+        total += VECTOR_HEADER(vectors[i])->len;
+    }
+    byte_t *out = first->align ? vector_init_aligned(first->tsize, total, first->align, first->a)
+                               : vector_init(first->tsize, total, first->a);
+    if (!out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Concat: allocation failed.\n");
+        return NULL;
+    }
+    VECTOR_HEADER(out)->type = first->type;
+    total = 0;
+    for (i = 0; i < n; i++)
+    {
+        vector_header_t *hdr = VECTOR_HEADER(vectors[i]);
+        vector_copy_range(hdr->type, out + total * hdr->tsize, vectors[i], hdr->len, hdr->tsize);
+        total += hdr->len;
+    }
+    VECTOR_HEADER(out)->len = total;
+    return out;
+}
+
+/* Hand the element storage over as a plain buffer, moving it to the start of the allocation */
+void *vector_detach(void *vector, size_t *len)
+{
+    if (!vector || !len)
+    {
+        VECTOR_DEBUG_PERROR("Vector Detach: given null vector or length pointer.\n");
+        return NULL;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    size_t n = hdr->len, tsize = hdr->tsize;
+    if (vector_is_shared(hdr))
+    {
+        /* Other owners keep the buffer, give out a copy instead */
+        void *raw = hdr->a->malloc(n ? n * tsize : 1);
+        if (!raw)
+        {
+            VECTOR_DEBUG_PERROR("Vector Detach: allocation failed.\n");
+            return NULL;
+        }
+        vector_copy_range(hdr->type, raw, vector, n, tsize);
+        vector_free(vector);
+        *len = n;
+        return raw;
+    }
+    byte_t *raw = (byte_t *)hdr - hdr->offset;
+    internal_vector_move_range(hdr->type, raw, vector, n, tsize);
+    *len = n;
+    return raw;
+}
+
+/* Wrap a buffer from a->malloc as a vector, the allocation grows by one header */
+void *vector_adopt(void *buf, size_t tsize, size_t len, size_t cap, allocator_t *a)
+{
+    if (!buf || !a)
+    {
+        VECTOR_DEBUG_PERROR("Vector Adopt: given null buffer or allocator.\n");
+        return NULL;
+    }
+    if (len > cap)
+    {
+        VECTOR_DEBUG_PERROR("Vector Adopt: length larger than capacity.\n");
+        return NULL;
+    }
+    byte_t *raw = a->realloc(buf, sizeof(vector_header_t) + cap * tsize);
+    if (!raw)
+    {
+        VECTOR_DEBUG_PERROR("Vector Adopt: realloc failed.\n");
+        return NULL;
+    }
+    memmove(raw + sizeof(vector_header_t), raw, len * tsize);
+    vector_header_t *hdr = (vector_header_t *)raw;
+    internal_vector_header_init(hdr, tsize, cap, a);
+    hdr->len = len;
+    return raw + sizeof(vector_header_t);
+}
+
 /* Resize vector capacity */
 void *vector_resize(void *vector, size_t cap)
 {
@@ -218,6 +546,15 @@ void *vector_resize(void *vector, size_t cap)
         VECTOR_DEBUG_PERROR("Vector Resize: null allocator in header.\n");
         return NULL;
     }
+    /* realloc does not keep an alignment above the allocator's own, copy instead */
+    /* Elements with a move hook cannot be relocated by realloc either */
+    if (vector_is_shared(hdr) || hdr->align || (hdr->type && hdr->type->move))
+        return vector_unshare(vector, cap);
+    if (hdr->len > cap)
+    {
+        internal_vector_destroy_range(hdr->type, (byte_t *)vector + cap * hdr->tsize, hdr->len - cap, hdr->tsize);
+        hdr->len = cap;
+    }
     vector_header_t *new_vector = hdr->a->realloc(hdr, cap * hdr->tsize + sizeof(vector_header_t));
     if (!new_vector)
     {
@@ -244,8 +581,13 @@ vector_status_t vector_pop_back(void *vector, void *out)
         VECTOR_DEBUG_PERROR("Vector Pop Back: empty vector.\n");
         return VEC_EMPTY;
     }
+    if (vector_is_shared(hdr))
+    {
+        VECTOR_DEBUG_PERROR("Vector Pop Back: vector is shared, call vector_unique first.\n");
+        return VEC_SHARED;
+    }
     hdr->len--;
-    memcpy(out, (byte_t *)vector + (hdr->len * hdr->tsize), hdr->tsize);
+    internal_vector_move_range(hdr->type, out, (byte_t *)vector + (hdr->len * hdr->tsize), 1, hdr->tsize);
     return VEC_OK;
 }
 
@@ -263,6 +605,8 @@ const char *vector_status_to_string(vector_status_t status)
         return "VEC_EMPTY";
     case VEC_INDEX_OOB:
         return "VEC_INDEX_OOB";
+    case VEC_SHARED:
+        return "VEC_SHARED";
     default:
         return "Unknown Vector Status";
     }
@@ -280,6 +624,9 @@ void *internal_vector_prepare_push_back(void *vptr, size_t item_size)
     vector_get_cap(vptr, &cap);
     vector_get_len(vptr, &len);
 
+    if (vector_is_shared(VECTOR_HEADER(vptr)))
+        return vector_unshare(vptr, len < cap ? cap : (cap + 1) * 2);
+
     if (vector_can_append(vptr) != VEC_OK)
     {
         void *tmp = vector_resize(vptr, (cap + 1) * 2);
@@ -312,7 +659,17 @@ void *internal_vector_prepare_insert(void *vptr, size_t item_size, size_t index)
         return NULL;
     }
 
-    if (vector_can_append(vptr) != VEC_OK)
+    if (vector_is_shared(VECTOR_HEADER(vptr)))
+    {
+        void *tmp = vector_unshare(vptr, len < cap ? cap : (cap + 1) * 2);
+        if (!tmp)
+        {
+            VECTOR_DEBUG_PERROR("Vector Insert: copy of shared vector failed.\n");
+            return NULL;
+        }
+        vptr = tmp;
+    }
+    else if (vector_can_append(vptr) != VEC_OK)
     {
         void *tmp = vector_resize(vptr, (cap + 1) * 2);
         if (!tmp)
@@ -324,9 +681,8 @@ void *internal_vector_prepare_insert(void *vptr, size_t item_size, size_t index)
     }
 
     /*shift elements right (leave space for new item) */
-    memmove((char *)vptr + (index + 1) * item_size,
-            (char *)vptr + index * item_size,
-            (len - index) * item_size);
+    internal_vector_move_range(VECTOR_HEADER(vptr)->type, (char *)vptr + (index + 1) * item_size,
+                      (char *)vptr + index * item_size, len - index, item_size);
 
     return vptr;
 }
@@ -341,4 +697,28 @@ void internal_vector_set_len(void *vector, size_t len)
     }
     vector_header_t *hdr = VECTOR_HEADER(vector);
     hdr->len = len;
-}
\ No newline at end of file
+}
+
+/* Get vector length (no status) */
+size_t internal_vector_len(const void *vector)
+{
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector Len: given null vector.\n");
+        return 0;
+    }
+    return VECTOR_HEADER(vector)->len;
+}
+
+void internal_vector_header_init(vector_header_t *hdr, size_t tsize, size_t cap, allocator_t *a)
+{
+    hdr->cap = cap;
+    hdr->len = 0;
+    hdr->tsize = tsize;
+    hdr->a = a;
+    atomic_init(&hdr->refs, 1);
+    hdr->offset = 0;
+    hdr->align = 0;
+    hdr->type = NULL;
+    hdr->reserved = 0;
+}
@@ -12,7 +12,8 @@ typedef enum
     VEC_ERR,
     VEC_FULL,
     VEC_EMPTY,
-    VEC_INDEX_OOB
+    VEC_INDEX_OOB,
+    VEC_SHARED
 } vector_status_t;
 
 /**
@@ -25,6 +26,30 @@ typedef struct allocator_t
     void (*free)(void *);             /**< Function to free memory. */
 } allocator_t;
 
+/**
+ * @brief Element lifecycle hooks attached to a vector with vector_init_typed().
+ *
+ * Any hook may be NULL, which means plain bytes for that operation: the
+ * functions of vector.h then copy, move and drop whole ranges at once. A type
+ * with a destroy hook must also have a copy hook, or copies of a shared vector
+ * would release the same resources twice; vector_init_typed() rejects it.
+ */
+typedef struct vector_type_t
+{
+    size_t tsize;                              /**< Size of each element. */
+    void (*destroy)(void *item);               /**< Release what item owns. Called by free, remove and truncating resize. */
+    void (*copy)(void *dst, const void *src);  /**< Duplicate src into raw memory at dst. Used when a shared vector is copied. */
+    void (*move)(void *dst, void *src);        /**< Relocate src into raw memory at dst, src is then dead. Replaces memmove. */
+} vector_type_t;
+
+/**
+ * @brief Lifecycle hooks for elements that are themselves vectors (void * to a vailed vector).
+ *
+ * Destroy frees the inner vector and copy shares it (see vector_share()), so
+ * vector_free() on the outer vector frees the whole nest.
+ */
+extern const vector_type_t vector_type_vector;
+
 /**
  * @brief Create a new vector of type T using a specified allocator.
  *
@@ -45,7 +70,31 @@ typedef struct allocator_t
 void *vector_init(size_t tsize, size_t cap, allocator_t *a);
 
 /**
- * @brief Free a vector.
+ * @brief Initialize a vector whose first element is aligned to align bytes.
+ *
+ * The allocation is padded so the header still sits directly in front of the
+ * elements; the vector keeps its alignment when it grows or is copied.
+ *
+ * @param tsize Size of each element (sizeof(T)).
+ * @param cap Initial capacity.
+ * @param align Alignment in bytes, a power of two.
+ * @param a Pointer to allocator_t.
+ * @return void* Pointer to elements on success, NULL on failure.
+ */
+void *vector_init_aligned(size_t tsize, size_t cap, size_t align, allocator_t *a);
+
+/**
+ * @brief Initialize a vector whose elements follow lifecycle hooks.
+ *
+ * @param type Element descriptor, must outlive the vector and have a copy hook if it has a destroy hook.
+ * @param cap Initial capacity.
+ * @param a Pointer to allocator_t.
+ * @return void* Pointer to elements on success, NULL on failure.
+ */
+void *vector_init_typed(const vector_type_t *type, size_t cap, allocator_t *a);
+
+/**
+ * @brief Free a vector, destroying its elements if it has a destroy hook.
  *
  * @param vector Vector pointer.
  * @return VEC_OK on success, VEC_ERR on error
@@ -81,41 +130,105 @@ vector_status_t vector_get_len(void *vector, size_t *out);
 /**
  * @brief Remove index from vector. Doesn't respect order.
  *
+ * The element is released with the destroy hook when the vector has one.
+ *
  * @param vector Vector pointer.
  * @param index Index to be removed.
- * @return VEC_OK on success, VEC_INDEX_OOB if index is out of bounds, VEC_ERR on error
+ * @return VEC_OK on success, VEC_INDEX_OOB if index is out of bounds, VEC_SHARED if the vector is shared, VEC_ERR on error
  */
 vector_status_t vector_remove(void *vector, size_t index);
 
 /**
  * @brief Remove index from vector. Respects order.
  *
+ * The element is released with the destroy hook when the vector has one.
+ *
  * @param vector Vector pointer.
  * @param index Index to be removed.
- * @return VEC_OK on success, VEC_INDEX_OOB if index is out of bounds, VEC_ERR on error
+ * @return VEC_OK on success, VEC_INDEX_OOB if index is out of bounds, VEC_SHARED if the vector is shared, VEC_ERR on error
  */
 vector_status_t vector_remove_ordered(void *vector, size_t index);
 
 /**
  * @brief Copies removes last value from vector and copies it to out.
  *
+ * With lifecycle hooks the element is moved, out owns it afterwards.
+ *
  * @param vector Vector pointer
  * @param out Reference to copy pop value to.
+ * @return VEC_OK on success, VEC_EMPTY if the vector is empty, VEC_SHARED if the vector is shared, VEC_ERR on error
  */
 vector_status_t vector_pop_back(void *vector, void *out);
 
 /**
  * @brief Copies the vector contents into a normal C array (no header).
  *
+ * Elements are duplicated with the copy hook when the vector has one.
+ *
  * @param vector Vector pointer.
  * @param malloc_fn malloc-like function for allocating the array.
  * @return Pointer to plain array or NULL on failure.
  */
 void *vector_normal_copy(void *vector, void *(*malloc_fn)(size_t));
 
+/**
+ * @brief Copy a vector into a new one whose capacity is exactly its length.
+ *
+ * Uses the same allocator, alignment and lifecycle hooks. Without a copy
+ * hook the header and elements are copied with one memcpy.
+ *
+ * @param vector Vector pointer.
+ * @return void* Pointer to the new vector's elements, NULL on failure.
+ */
+void *vector_clone(void *vector);
+
+/**
+ * @brief Join vectors end to end into a new vector, allocated once at the total length.
+ *
+ * All vectors must have the same element size and lifecycle hooks; the result
+ * uses the first one's allocator and alignment.
+ *
+ * @param vectors Array of n vector pointers.
+ * @param n Number of vectors, at least one.
+ * @return void* Pointer to the new vector's elements, NULL on failure or mismatch.
+ */
+void *vector_concat(void **vectors, size_t n);
+
+/**
+ * @brief Turn a vector into a plain buffer without copying.
+ *
+ * The elements are moved to the start of the vector's allocation, which the
+ * caller then owns and releases with the vector's allocator free. The
+ * vector pointer is invalid afterwards. A shared vector is copied instead
+ * and loses one owner. Alignment from vector_init_aligned() is not kept.
+ *
+ * @param vector Vector pointer.
+ * @param len Receives the number of elements.
+ * @return Pointer to the plain buffer, NULL on failure.
+ */
+void *vector_detach(void *vector, size_t *len);
+
+/**
+ * @brief Turn a buffer from a->malloc (or vector_detach()) into a vector.
+ *
+ * The buffer is reallocated to make room for the header and the elements
+ * are moved up behind it; when realloc can grow in place nothing else is
+ * allocated. buf must not be used afterwards.
+ *
+ * @param buf Buffer allocated with a.
+ * @param tsize Size of each element.
+ * @param len Number of elements in buf.
+ * @param cap Capacity of the resulting vector, at least len.
+ * @param a Pointer to allocator_t that allocated buf.
+ * @return void* Pointer to elements on success, NULL on failure (buf is then still valid).
+ */
+void *vector_adopt(void *buf, size_t tsize, size_t len, size_t cap, allocator_t *a);
+
 /**
  * @brief Resize the vector to a new capacity.
  *
+ * Elements cut off by a smaller capacity are released with the destroy hook.
+ *
  * @param vector Vector pointer.
  * @param cap New capacity.
  * @return Pointer to resized vector on success, NULL on failure.
@@ -130,6 +243,44 @@ void *vector_resize(void *vector, size_t cap);
  */
 void *vector_shrink_to_fit(void *vector_ptr);
 
+/**
+ * @brief Share the vector with another owner in O(1).
+ *
+ * Both owners hold the same pointer until one of them mutates through the
+ * vector API: push back, insert and resize first copy the buffer when it has
+ * more than one owner, so the other owners keep seeing the old contents.
+ * Each owner calls vector_free() once.
+ *
+ * Functions that change a vector in place without returning it, such as
+ * vector_remove() and vector_pop_back(), return VEC_SHARED instead. Call
+ * vector_unique() before them, and before direct element writes
+ * (v[i] = x), on a vector that may be shared.
+ *
+ * @param vector Vector pointer.
+ * @return The same vector pointer, NULL on error.
+ */
+void *vector_share(void *vector);
+
+/**
+ * @brief Give the caller its own copy of a shared vector.
+ *
+ * Returns the vector itself when it has a single owner. Otherwise copies it
+ * and drops the caller's reference to the original.
+ *
+ * @param vector Vector pointer.
+ * @return Pointer to an unshared vector, NULL on failure.
+ */
+void *vector_make_unique(void *vector);
+
+/**
+ * @brief Get the number of owners sharing the vector's buffer.
+ *
+ * @param vector Vector pointer.
+ * @param out Pointer to size_t where the count will be written.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_get_refs(void *vector, size_t *out);
+
 /**
  * @brief Returns string that matches status
  *
@@ -178,6 +329,23 @@ const char *vector_status_to_string(vector_status_t status);
  */
 #define vector_shrink(v) ((v) = vector_shrink_to_fit(v))
 
+/**
+ * @brief Makes v its own unshared copy before in-place changes.
+ *
+ * v is reassigned only on success; if the copy fails v stays shared and
+ * in-place calls keep returning VEC_SHARED.
+ *
+ * @param v Vector pointer (may be reassigned).
+ */
+#define vector_unique(v)                     \
+    do                                       \
+    {                                        \
+        void *_tmp = vector_make_unique(v);  \
+        if (!_tmp)                           \
+            break;                           \
+        (v) = _tmp; /* Unshared if needed */ \
+    } while (0)
+
 /**
  * @brief Iterate over a vector with automatic type deduction.
  *
@@ -224,6 +392,60 @@ const char *vector_status_to_string(vector_status_t status);
          (v) && ((_i < (_len == 0 && vector_get_len((v), &_len) == VEC_OK ? _len : _len)) && ((var) = (v)[_i], 1)); \
          ++_i)
 
+#if defined(__GNUC__)
+#define VECTOR_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define VECTOR_PREFETCH(p) ((void)0)
+#endif
+
+/* Elements ahead that vector_foreach_ref_prefetch() prefetches by default */
+#define VECTOR_PREFETCH_DISTANCE 8
+
+/**
+ * @brief Iterate over a vector by reference with a pointer.
+ *
+ * The length is read once before the loop and the condition is a single
+ * pointer compare, so the body can be unrolled and vectorized. Writing
+ * through _p changes the vector in place; call vector_unique(v) first when
+ * it may be shared.
+ *
+ * @param _p A pointer variable of the element type receiving each element's address.
+ * @param _end A pointer variable of the same type, set to one past the last element.
+ * @param v The vector pointer (NULL runs no iterations).
+ *
+ * Example:
+ * @code
+ * int *p, *end;
+ * vector_foreach_ref(p, end, vec)
+ *     *p *= 2;
+ * @endcode
+ */
+#define vector_foreach_ref(_p, _end, v) \
+    for ((_p) = (v), (_end) = (_p) + ((v) ? internal_vector_len(v) : 0); (_p) != (_end); ++(_p))
+
+/**
+ * @brief vector_foreach_ref() over a vector of pointers that prefetches what the element dist ahead points to.
+ *
+ * Meant for vectors of vectors and other pointer elements whose targets are
+ * scattered across the heap, where each step would otherwise wait on a miss.
+ *
+ * @param _p A pointer-to-pointer variable receiving each element's address.
+ * @param _end A variable of the same type, set to one past the last element.
+ * @param v The vector pointer (NULL runs no iterations).
+ * @param dist Elements to look ahead, VECTOR_PREFETCH_DISTANCE is a good start.
+ *
+ * Example:
+ * @code
+ * int **row, **end;
+ * vector_foreach_ref_prefetch(row, end, rows, VECTOR_PREFETCH_DISTANCE)
+ *     total += (*row)[0];
+ * @endcode
+ */
+#define vector_foreach_ref_prefetch(_p, _end, v, dist)                                           \
+    for ((_p) = (v), (_end) = (_p) + ((v) ? internal_vector_len(v) : 0);                         \
+         (_p) != (_end) && ((_end) - (_p) > (dist) ? VECTOR_PREFETCH(*((_p) + (dist))) : (void)0, 1); \
+         ++(_p))
+
 /* Internal methdods */
 
 #ifdef VECTOR_DEBUG
@@ -248,6 +470,9 @@ void *internal_vector_prepare_insert(void *vptr, size_t item_size, size_t index)
 
 void internal_vector_set_len(void *vector, size_t len);
 
+/* Length without the status check, read once by the pointer loops */
+size_t internal_vector_len(const void *vector);
+
 #define internal_vector_push_back(v, item)                                 \
     do                                                                     \
     {                                                                      \
@@ -0,0 +1,228 @@
+#include "vector_append.h"
+#include "vector_internal.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#define VECTOR_APPEND_SEGMENTS 64
+#define VECTOR_APPEND_BUSY ((byte_t *)1) /* segment is being allocated */
+
+/*
+ * Segment 0 is a regular vailed vector of 2^shift elements so seal can grow it
+ * in place. Segment s > 0 holds indices [2^(shift+s-1), 2^(shift+s)).
+ */
+struct vector_append_t
+{
+    atomic_size_t len; /* reserved slots, the only contended field */
+    byte_t pad[VECTOR_CACHE_LINE - sizeof(atomic_size_t)];
+    size_t tsize;
+    size_t shift;
+    allocator_t *a;
+    atomic_size_t lost; /* slots reserved while their segment could not be allocated */
+    _Atomic(byte_t *) seg[VECTOR_APPEND_SEGMENTS];
+};
+
+static size_t vector_append_log2(size_t x)
+{
+#if defined(__GNUC__)
+    return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(x);
+#else
+    size_t r = 0;
+    while (x >>= 1)
+        r++;
+    return r;
+#endif
+}
+
+/* Split an index into segment and offset */
+static size_t vector_append_locate(vector_append_t *va, size_t index, size_t *offset)
+{
+    size_t block = index >> va->shift;
+    if (block == 0)
+    {
+        *offset = index;
+        return 0;
+    }
+    size_t s = vector_append_log2(block) + 1;
+    *offset = index - ((size_t)1 << (va->shift + s - 1));
+    return s;
+}
+
+/* Return segment s, allocating it if this thread is the first to need it */
+static byte_t *vector_append_segment(vector_append_t *va, size_t s)
+{
+    for (;;)
+    {
+        byte_t *p = atomic_load_explicit(&va->seg[s], memory_order_acquire);
+        if (p && p != VECTOR_APPEND_BUSY)
+            return p;
+        if (!p)
+        {
+            byte_t *expected = NULL;
+            if (atomic_compare_exchange_strong(&va->seg[s], &expected, VECTOR_APPEND_BUSY))
+            {
+                p = va->a->malloc(va->tsize << (va->shift + s - 1));
+                if (!p)
+                {
+                    VECTOR_DEBUG_PERROR("Vector Append: segment allocation failed.\n");
+                }
+                atomic_store_explicit(&va->seg[s], p, memory_order_release);
+                return p;
+            }
+        }
+        sched_yield(); /* another thread is allocating it */
+    }
+}
+
+vector_append_t *vector_append_init(size_t tsize, size_t cap, allocator_t *a)
+{
+    if (!a)
+    {
+        VECTOR_DEBUG_PERROR("Vector Append Init: given null allocator.\n");
+        return NULL;
+    }
+    vector_append_t *va = a->malloc(sizeof(vector_append_t));
+    if (!va)
+    {
+        VECTOR_DEBUG_PERROR("Vector Append Init: allocation failed.\n");
+        return NULL;
+    }
+    va->shift = 0;
+    while (((size_t)1 << va->shift) < cap)
+        va->shift++;
+    va->tsize = tsize;
+    va->a = a;
+    atomic_init(&va->len, 0);
+    atomic_init(&va->lost, 0);
+    size_t s;
+    for (s = 0; s < VECTOR_APPEND_SEGMENTS; s++)
+        atomic_init(&va->seg[s], NULL);
+
+    byte_t *first = vector_init(tsize, (size_t)1 << va->shift, a);
+    if (!first)
+    {
+        VECTOR_DEBUG_PERROR("Vector Append Init: allocation failed.\n");
+        a->free(va);
+        return NULL;
+    }
+    atomic_init(&va->seg[0], first);
+    return va;
+}
+
+vector_status_t vector_append_free(vector_append_t *va)
+{
+    if (!va)
+    {
+        VECTOR_DEBUG_PERROR("Vector Append Free: given null.\n");
+        return VEC_ERR;
+    }
+    size_t s;
+    if (atomic_load(&va->seg[0]))
+        vector_free(atomic_load(&va->seg[0]));
+    for (s = 1; s < VECTOR_APPEND_SEGMENTS; s++)
+    {
+        byte_t *p = atomic_load(&va->seg[s]);
+        if (p)
+            va->a->free(p);
+    }
+    va->a->free(va);
+    return VEC_OK;
+}
+
+void *vector_append_emplace(vector_append_t *va, size_t *index)
+{
+    if (!va)
+    {
+        VECTOR_DEBUG_PERROR("Vector Append Emplace: given null.\n");
+        return NULL;
+    }
+    size_t i = atomic_fetch_add_explicit(&va->len, 1, memory_order_relaxed);
+    size_t offset;
+    byte_t *seg = vector_append_segment(va, vector_append_locate(va, i, &offset));
+    if (!seg)
+    {
+        /* The index stays taken but holds no element, seal refuses the vector */
+        atomic_fetch_add_explicit(&va->lost, 1, memory_order_relaxed);
+        return NULL;
+    }
+    if (index)
+        *index = i;
+    return seg + offset * va->tsize;
+}
+
+vector_status_t vector_append_push(vector_append_t *va, const void *item)
+{
+    if (!item)
+    {
+        VECTOR_DEBUG_PERROR("Vector Append Push: given null item.\n");
+        return VEC_ERR;
+    }
+    void *slot = vector_append_emplace(va, NULL);
+    if (!slot)
+        return VEC_ERR;
+    memcpy(slot, item, va->tsize);
+    return VEC_OK;
+}
+
+void *vector_append_at(vector_append_t *va, size_t index)
+{
+    if (!va || index >= atomic_load_explicit(&va->len, memory_order_relaxed))
+    {
+        VECTOR_DEBUG_PERROR("Vector Append At: given null or index out of bounds.\n");
+        return NULL;
+    }
+    size_t offset;
+    size_t s = vector_append_locate(va, index, &offset);
+    byte_t *seg = atomic_load_explicit(&va->seg[s], memory_order_acquire);
+    if (!seg || seg == VECTOR_APPEND_BUSY)
+        return NULL;
+    return seg + offset * va->tsize;
+}
+
+size_t vector_append_len(vector_append_t *va)
+{
+    if (!va)
+    {
+        VECTOR_DEBUG_PERROR("Vector Append Len: given null.\n");
+        return 0;
+    }
+    return atomic_load_explicit(&va->len, memory_order_relaxed);
+}
+
+void *vector_append_seal(vector_append_t *va)
+{
+    if (!va)
+    {
+        VECTOR_DEBUG_PERROR("Vector Append Seal: given null.\n");
+        return NULL;
+    }
+    if (atomic_load(&va->lost))
+    {
+        VECTOR_DEBUG_PERROR("Vector Append Seal: a slot was reserved without storage.\n");
+        vector_append_free(va);
+        return NULL;
+    }
+    size_t len = atomic_load(&va->len);
+    byte_t *out = vector_resize(atomic_load(&va->seg[0]), len);
+    if (!out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Append Seal: resize failed.\n");
+        vector_append_free(va);
+        return NULL;
+    }
+    atomic_store(&va->seg[0], out);
+
+    size_t s, start = (size_t)1 << va->shift;
+    for (s = 1; start < len; s++, start <<= 1)
+    {
+        byte_t *seg = atomic_load(&va->seg[s]);
+        size_t n = len - start < start ? len - start : start;
+        if (seg)
+            memcpy(out + start * va->tsize, seg, n * va->tsize);
+    }
+    internal_vector_set_len(out, len);
+
+    atomic_store(&va->seg[0], NULL);
+    vector_append_free(va);
+    return out;
+}
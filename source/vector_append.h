@@ -0,0 +1,93 @@
+#ifndef _VECTOR_APPEND_H
+#define _VECTOR_APPEND_H
+
+#include "vector.h"
+
+/**
+ * @brief Append-only vector that many threads can push into at once.
+ *
+ * Slots are reserved with an atomic fetch-add on the length. Storage grows by
+ * adding segments of doubling size, so elements never move and pointers from
+ * vector_append_emplace() and vector_append_at() stay valid until sealed.
+ */
+typedef struct vector_append_t vector_append_t;
+
+/**
+ * @brief Create a concurrent append vector for elements of type T.
+ *
+ * @param T Type of the elements.
+ * @param a Pointer to allocator_t.
+ * @return vector_append_t* on success, NULL on failure.
+ */
+#define vector_append(T, a) vector_append_init(sizeof(T), VECTOR_DEFAULT_CAP, a)
+
+/**
+ * @brief Initialize a concurrent append vector.
+ *
+ * @param tsize Size of each element (sizeof(T)).
+ * @param cap Size of the first segment, rounded up to a power of two.
+ * @param a Pointer to allocator_t.
+ * @return vector_append_t* on success, NULL on failure.
+ */
+vector_append_t *vector_append_init(size_t tsize, size_t cap, allocator_t *a);
+
+/**
+ * @brief Free a concurrent append vector and all of its segments.
+ *
+ * @param va Append vector.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_append_free(vector_append_t *va);
+
+/**
+ * @brief Reserve the next slot and return a pointer to it. Thread safe.
+ *
+ * The caller writes the element through the returned pointer.
+ *
+ * @param va Append vector.
+ * @param index Optional, receives the index of the reserved slot.
+ * @return Pointer to the slot, NULL if its segment could not be allocated. The
+ *         index is then reserved without an element and vector_append_seal() fails.
+ */
+void *vector_append_emplace(vector_append_t *va, size_t *index);
+
+/**
+ * @brief Copy one item into the next slot. Thread safe.
+ *
+ * @param va Append vector.
+ * @param item Pointer to the item to copy in.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_append_push(vector_append_t *va, const void *item);
+
+/**
+ * @brief Pointer to the element at index. No bounds check beyond reserved slots.
+ *
+ * @param va Append vector.
+ * @param index Index of a reserved slot.
+ * @return Pointer to the element, NULL if out of range.
+ */
+void *vector_append_at(vector_append_t *va, size_t index);
+
+/**
+ * @brief Number of reserved slots.
+ *
+ * @param va Append vector.
+ * @return Number of reserved slots, 0 on error.
+ */
+size_t vector_append_len(vector_append_t *va);
+
+/**
+ * @brief Turn the append vector into a regular contiguous vailed vector.
+ *
+ * All producers must have finished writing. The first segment is resized in
+ * place and the remaining segments are copied after it. The append vector is
+ * freed by this call, on success and on failure.
+ *
+ * @param va Append vector.
+ * @return Vailed vector with exactly len elements, NULL on failure or if any
+ *         emplace or push failed to allocate its slot.
+ */
+void *vector_append_seal(vector_append_t *va);
+
+#endif /* _VECTOR_APPEND_H */
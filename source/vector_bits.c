@@ -0,0 +1,492 @@
+#include "vector_bits.h"
+#include "vector_internal.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define VECTOR_BITS_X86 1
+#endif
+
+#define VECTOR_BITS_WORDS(bits) (((bits) + 63) / 64)
+
+/* Zero the bits past the length in the last word */
+static void vector_bits_trim(uint64_t *bv, size_t bits)
+{
+    if (bits & 63)
+        bv[bits / 64] &= ((uint64_t)1 << (bits & 63)) - 1;
+}
+
+static size_t vector_bits_ctz(uint64_t x)
+{
+#if defined(__GNUC__)
+    return (size_t)__builtin_ctzll(x);
+#else
+    size_t r = 0;
+    while (!(x & 1))
+    {
+        x >>= 1;
+        r++;
+    }
+    return r;
+#endif
+}
+
+/* -------- Popcount kernels -------- */
+
+static size_t vector_bits_popcount_generic(const uint64_t *w, size_t n)
+{
+    size_t i, total = 0;
+    for (i = 0; i < n; i++)
+    {
+        uint64_t x = w[i];
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        total += (size_t)((x * 0x0101010101010101ULL) >> 56);
+    }
+    return total;
+}
+
+#ifdef VECTOR_BITS_X86
+__attribute__((target("popcnt"))) static size_t vector_bits_popcount_popcnt(const uint64_t *w, size_t n)
+{
+    size_t i, total = 0;
+    for (i = 0; i < n; i++)
+        total += (size_t)__builtin_popcountll(w[i]);
+    return total;
+}
+
+/*
+ * Nibble lookup through vpshufb: per-byte counts are summed in 8-bit lanes for
+ * up to 31 iterations (31 * 8 < 256) and then widened with vpsadbw.
+ */
+__attribute__((target("avx2,popcnt"))) static size_t vector_bits_popcount_avx2(const uint64_t *w, size_t n)
+{
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0, k;
+    while (i + 4 <= n)
+    {
+        __m256i local = _mm256_setzero_si256();
+        for (k = 0; k < 31 && i + 4 <= n; k++, i += 4)
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(w + i));
+            __m256i lo = _mm256_and_si256(v, low);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+            local = _mm256_add_epi8(local, _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo), _mm256_shuffle_epi8(lut, hi)));
+        }
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(local, _mm256_setzero_si256()));
+    }
+    size_t total = (size_t)_mm256_extract_epi64(acc, 0) + (size_t)_mm256_extract_epi64(acc, 1) +
+                   (size_t)_mm256_extract_epi64(acc, 2) + (size_t)_mm256_extract_epi64(acc, 3);
+    for (; i < n; i++)
+        total += (size_t)__builtin_popcountll(w[i]);
+    return total;
+}
+#endif
+
+typedef size_t (*vector_bits_popcount_t)(const uint64_t *w, size_t n);
+
+static vector_bits_popcount_t vector_bits_popcount_best;
+static pthread_once_t vector_bits_popcount_once = PTHREAD_ONCE_INIT;
+
+static void vector_bits_popcount_resolve(void)
+{
+    vector_bits_popcount_best = vector_bits_popcount_generic;
+#ifdef VECTOR_BITS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        vector_bits_popcount_best = vector_bits_popcount_avx2;
+    else if (__builtin_cpu_supports("popcnt"))
+        vector_bits_popcount_best = vector_bits_popcount_popcnt;
+#endif
+}
+
+/* Best kernel this CPU supports, probed once per process */
+static vector_bits_popcount_t vector_bits_popcount_kernel(void)
+{
+    pthread_once(&vector_bits_popcount_once, vector_bits_popcount_resolve);
+    return vector_bits_popcount_best;
+}
+
+/* -------- Bit vector -------- */
+
+uint64_t *vector_bits_init(size_t cap, allocator_t *a)
+{
+    return vector_init(sizeof(uint64_t), VECTOR_BITS_WORDS(cap), a);
+}
+
+size_t vector_bits_len(const uint64_t *bv)
+{
+    if (!bv)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Len: given null bit vector.\n");
+        return 0;
+    }
+    return VECTOR_HEADER(bv)->len;
+}
+
+uint64_t *vector_bits_resize(uint64_t *bv, size_t bits)
+{
+    if (!bv)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Resize: given null bit vector.\n");
+        return NULL;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(bv);
+    size_t used = VECTOR_BITS_WORDS(hdr->len);
+    size_t words = VECTOR_BITS_WORDS(bits);
+    if (words > hdr->cap)
+    {
+        size_t cap = hdr->cap * 2 > words ? hdr->cap * 2 : words;
+        uint64_t *tmp = vector_resize(bv, cap);
+        if (!tmp)
+        {
+            VECTOR_DEBUG_PERROR("Vector Bits Resize: resize failed.\n");
+            return NULL;
+        }
+        bv = tmp;
+        hdr = VECTOR_HEADER(bv);
+    }
+    if (words > used)
+        memset(bv + used, 0, (words - used) * sizeof(uint64_t));
+    hdr->len = bits;
+    vector_bits_trim(bv, bits);
+    return bv;
+}
+
+uint64_t *internal_vector_bits_push(uint64_t *bv, int bit)
+{
+    if (!bv)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Push: given null.\n");
+        return NULL;
+    }
+    size_t i = VECTOR_HEADER(bv)->len;
+    if (i & 63)
+        VECTOR_HEADER(bv)->len++; /* the word is in use and already zero past the length */
+    else if (!(bv = vector_bits_resize(bv, i + 1)))
+        return NULL;
+    if (bit)
+        vector_bits_set(bv, i);
+    return bv;
+}
+
+/* Word count shared by two bit vectors of equal length */
+static int vector_bits_pair(const uint64_t *dst, const uint64_t *src, size_t *words)
+{
+    if (!dst || !src || VECTOR_HEADER(dst)->len != VECTOR_HEADER(src)->len)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits: given null or different length bit vectors.\n");
+        return 0;
+    }
+    *words = VECTOR_BITS_WORDS(VECTOR_HEADER(dst)->len);
+    return 1;
+}
+
+/* Plain word loops, left to the compiler's vectorizer */
+
+vector_status_t vector_bits_and(uint64_t *dst, const uint64_t *src)
+{
+    size_t i, n;
+    if (!vector_bits_pair(dst, src, &n))
+        return VEC_ERR;
+    for (i = 0; i < n; i++)
+        dst[i] &= src[i];
+    return VEC_OK;
+}
+
+vector_status_t vector_bits_or(uint64_t *dst, const uint64_t *src)
+{
+    size_t i, n;
+    if (!vector_bits_pair(dst, src, &n))
+        return VEC_ERR;
+    for (i = 0; i < n; i++)
+        dst[i] |= src[i];
+    return VEC_OK;
+}
+
+vector_status_t vector_bits_xor(uint64_t *dst, const uint64_t *src)
+{
+    size_t i, n;
+    if (!vector_bits_pair(dst, src, &n))
+        return VEC_ERR;
+    for (i = 0; i < n; i++)
+        dst[i] ^= src[i];
+    return VEC_OK;
+}
+
+vector_status_t vector_bits_andnot(uint64_t *dst, const uint64_t *src)
+{
+    size_t i, n;
+    if (!vector_bits_pair(dst, src, &n))
+        return VEC_ERR;
+    for (i = 0; i < n; i++)
+        dst[i] &= ~src[i];
+    return VEC_OK;
+}
+
+vector_status_t vector_bits_not(uint64_t *bv)
+{
+    if (!bv)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Not: given null bit vector.\n");
+        return VEC_ERR;
+    }
+    size_t i, bits = VECTOR_HEADER(bv)->len, n = VECTOR_BITS_WORDS(bits);
+    for (i = 0; i < n; i++)
+        bv[i] = ~bv[i];
+    vector_bits_trim(bv, bits);
+    return VEC_OK;
+}
+
+size_t vector_bits_count(const uint64_t *bv)
+{
+    if (!bv)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Count: given null bit vector.\n");
+        return 0;
+    }
+    return vector_bits_popcount_kernel()(bv, VECTOR_BITS_WORDS(VECTOR_HEADER(bv)->len));
+}
+
+size_t vector_bits_next(const uint64_t *bv, size_t from)
+{
+    if (!bv)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Next: given null bit vector.\n");
+        return 0;
+    }
+    size_t bits = VECTOR_HEADER(bv)->len;
+    if (from >= bits)
+        return bits;
+    size_t w = from / 64, n = VECTOR_BITS_WORDS(bits);
+    uint64_t x = bv[w] & (~(uint64_t)0 << (from & 63));
+    while (!x)
+    {
+        if (++w == n)
+            return bits;
+        x = bv[w];
+    }
+    return w * 64 + vector_bits_ctz(x);
+}
+
+/* -------- Rank/select -------- */
+
+#define VECTOR_BITS_ENTRY_WORDS 32 /* 2048 bits per lower entry */
+#define VECTOR_BITS_BLOCK_WORDS 8  /* 512 bits per block */
+#define VECTOR_BITS_UPPER_SHIFT 32 /* lower entries count relative to 2^32 bit blocks */
+
+/*
+ * Lower entry layout: bits 0-31 ones before the entry within its upper block,
+ * then the ones of blocks 0, 1 and 2 in 10 bits each.
+ */
+#define VECTOR_BITS_ENTRY_BASE(e) ((size_t)((e) & 0xffffffffu))
+#define VECTOR_BITS_ENTRY_BLOCK(e, b) ((size_t)(((e) >> (32 + 10 * (b))) & 0x3ff))
+
+struct vector_bits_rank_t
+{
+    const uint64_t *bv;
+    size_t bits;
+    size_t ones;
+    vector_bits_popcount_t popcount;
+    allocator_t *a;
+    size_t *upper;     /* ones before each 2^32 bit block */
+    uint64_t *lower;   /* one entry per 2048 bits, plus one for the end */
+    uint32_t *samples; /* lower entry holding every VECTOR_BITS_SELECT_SAMPLE-th one */
+};
+
+/* Ones before lower entry j */
+static size_t vector_bits_entry_ones(const vector_bits_rank_t *r, size_t j)
+{
+    return r->upper[(j * VECTOR_BITS_ENTRY_WORDS * 64) >> VECTOR_BITS_UPPER_SHIFT] + VECTOR_BITS_ENTRY_BASE(r->lower[j]);
+}
+
+/* Position of the set bit with rank k inside one word */
+static size_t vector_bits_select_word(uint64_t x, size_t k)
+{
+    /* Per-byte counts, then the byte, then the bit */
+    uint64_t bytes = x - ((x >> 1) & 0x5555555555555555ULL);
+    bytes = (bytes & 0x3333333333333333ULL) + ((bytes >> 2) & 0x3333333333333333ULL);
+    bytes = (bytes + (bytes >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    size_t shift = 0;
+    while (k >= ((bytes >> shift) & 0xff))
+    {
+        k -= (bytes >> shift) & 0xff;
+        shift += 8;
+    }
+    x >>= shift;
+    while (k--)
+        x &= x - 1;
+    return shift + vector_bits_ctz(x);
+}
+
+vector_bits_rank_t *vector_bits_rank_init(const uint64_t *bv)
+{
+    if (!bv)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Rank Init: given null bit vector.\n");
+        return NULL;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(bv);
+    allocator_t *a = hdr->a;
+    size_t bits = hdr->len, words = VECTOR_BITS_WORDS(bits);
+    size_t entries = bits / (VECTOR_BITS_ENTRY_WORDS * 64) + 1;
+    size_t uppers = (bits >> VECTOR_BITS_UPPER_SHIFT) + 1;
+
+    vector_bits_rank_t *r = a->malloc(sizeof(vector_bits_rank_t));
+    if (!r)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Rank Init: allocation failed.\n");
+        return NULL;
+    }
+    r->bv = bv;
+    r->bits = bits;
+    r->popcount = vector_bits_popcount_kernel();
+    r->a = a;
+    r->upper = vector_init(sizeof(size_t), uppers, a);
+    r->lower = vector_init(sizeof(uint64_t), entries, a);
+    r->samples = vector_init(sizeof(uint32_t), VECTOR_DEFAULT_CAP, a);
+    if (!r->upper || !r->lower || !r->samples)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Rank Init: allocation failed.\n");
+        vector_bits_rank_free(r);
+        return NULL;
+    }
+
+    size_t j, b, total = 0, sampled = 0;
+    for (j = 0; j < entries; j++)
+    {
+        size_t pos = j * VECTOR_BITS_ENTRY_WORDS * 64;
+        if ((pos & (((size_t)1 << VECTOR_BITS_UPPER_SHIFT) - 1)) == 0)
+            r->upper[pos >> VECTOR_BITS_UPPER_SHIFT] = total;
+        uint64_t entry = total - r->upper[pos >> VECTOR_BITS_UPPER_SHIFT];
+        size_t in_entry = 0;
+        for (b = 0; b < VECTOR_BITS_ENTRY_WORDS / VECTOR_BITS_BLOCK_WORDS; b++)
+        {
+            size_t w = j * VECTOR_BITS_ENTRY_WORDS + b * VECTOR_BITS_BLOCK_WORDS;
+            size_t n = w >= words ? 0 : (words - w < VECTOR_BITS_BLOCK_WORDS ? words - w : VECTOR_BITS_BLOCK_WORDS);
+            size_t c = n ? r->popcount(bv + w, n) : 0;
+            if (b < 3)
+                entry |= (uint64_t)c << (32 + 10 * b);
+            in_entry += c;
+        }
+        r->lower[j] = entry;
+
+        /* Sample every VECTOR_BITS_SELECT_SAMPLE-th one that falls in this entry */
+        for (; sampled * VECTOR_BITS_SELECT_SAMPLE < total + in_entry; sampled++)
+        {
+            vector_push_back(r->samples, (uint32_t)j);
+            if (VECTOR_HEADER(r->samples)->len == sampled)
+            {
+                VECTOR_DEBUG_PERROR("Vector Bits Rank Init: allocation failed.\n");
+                vector_bits_rank_free(r);
+                return NULL;
+            }
+        }
+        total += in_entry;
+    }
+    internal_vector_set_len(r->upper, uppers);
+    internal_vector_set_len(r->lower, entries);
+    r->ones = total;
+    return r;
+}
+
+vector_status_t vector_bits_rank_free(vector_bits_rank_t *r)
+{
+    if (!r)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Rank Free: given null index.\n");
+        return VEC_ERR;
+    }
+    if (r->upper)
+        vector_free(r->upper);
+    if (r->lower)
+        vector_free(r->lower);
+    if (r->samples)
+        vector_free(r->samples);
+    r->a->free(r);
+    return VEC_OK;
+}
+
+size_t vector_bits_rank(const vector_bits_rank_t *r, size_t i)
+{
+    if (!r || i > r->bits)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Rank: given null index or position out of bounds.\n");
+        return 0;
+    }
+    size_t j = i / (VECTOR_BITS_ENTRY_WORDS * 64);
+    uint64_t entry = r->lower[j];
+    size_t ones = vector_bits_entry_ones(r, j);
+    size_t block = (i / (VECTOR_BITS_BLOCK_WORDS * 64)) % (VECTOR_BITS_ENTRY_WORDS / VECTOR_BITS_BLOCK_WORDS);
+    size_t b;
+    for (b = 0; b < block; b++)
+        ones += VECTOR_BITS_ENTRY_BLOCK(entry, b);
+    size_t w = j * VECTOR_BITS_ENTRY_WORDS + block * VECTOR_BITS_BLOCK_WORDS;
+    if (i / 64 > w)
+        ones += r->popcount(r->bv + w, i / 64 - w);
+    if (i & 63)
+    {
+        uint64_t last = r->bv[i / 64] & (((uint64_t)1 << (i & 63)) - 1);
+        ones += r->popcount(&last, 1);
+    }
+    return ones;
+}
+
+size_t vector_bits_select(const vector_bits_rank_t *r, size_t k)
+{
+    if (!r)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Select: given null index.\n");
+        return 0;
+    }
+    if (k >= r->ones)
+        return r->bits;
+
+    /* Last entry with at most k ones before it, between the surrounding samples */
+    size_t s = k / VECTOR_BITS_SELECT_SAMPLE, nsamples;
+    vector_get_len(r->samples, &nsamples);
+    size_t lo = r->samples[s];
+    size_t hi = s + 1 < nsamples ? r->samples[s + 1] : VECTOR_HEADER(r->lower)->len - 1;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (vector_bits_entry_ones(r, mid) <= k)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    k -= vector_bits_entry_ones(r, lo);
+
+    size_t b, w = lo * VECTOR_BITS_ENTRY_WORDS;
+    for (b = 0; b < 3 && k >= VECTOR_BITS_ENTRY_BLOCK(r->lower[lo], b); b++)
+    {
+        k -= VECTOR_BITS_ENTRY_BLOCK(r->lower[lo], b);
+        w += VECTOR_BITS_BLOCK_WORDS;
+    }
+    for (;; w++)
+    {
+        size_t c = r->popcount(r->bv + w, 1);
+        if (k < c)
+            return w * 64 + vector_bits_select_word(r->bv[w], k);
+        k -= c;
+    }
+}
+
+size_t vector_bits_rank_bytes(const vector_bits_rank_t *r)
+{
+    if (!r)
+    {
+        VECTOR_DEBUG_PERROR("Vector Bits Rank Bytes: given null index.\n");
+        return 0;
+    }
+    size_t uppers, entries, samples;
+    vector_get_len(r->upper, &uppers);
+    vector_get_len(r->lower, &entries);
+    vector_get_len(r->samples, &samples);
+    return sizeof(vector_bits_rank_t) + uppers * sizeof(size_t) + entries * sizeof(uint64_t) + samples * sizeof(uint32_t);
+}
@@ -0,0 +1,208 @@
+#ifndef _VECTOR_BITS_H
+#define _VECTOR_BITS_H
+
+#include "vector.h"
+
+/**
+ * @brief Create an empty bit vector using a specified allocator.
+ *
+ * A bit vector is a vailed array of 64-bit words: bit i lives in word i / 64
+ * at position i % 64. The header counts the length in bits and the capacity
+ * in words, so vector_get_len() returns the number of bits. Bits past the
+ * length in the last word are always zero. Free it with vector_free(); do not
+ * pass it to vector_share() or the element functions of vector.h.
+ *
+ * @param a Pointer to allocator_t.
+ * @return uint64_t* Pointer to the words on success, NULL on failure.
+ */
+#define vector_bits(a) vector_bits_init(VECTOR_DEFAULT_CAP * 64, a)
+
+/**
+ * @brief Initialize a bit vector.
+ *
+ * @param cap Initial capacity in bits, rounded up to whole words.
+ * @param a Pointer to allocator_t.
+ * @return uint64_t* Pointer to the words on success, NULL on failure.
+ */
+uint64_t *vector_bits_init(size_t cap, allocator_t *a);
+
+/**
+ * @brief Get the length in bits.
+ *
+ * @param bv Bit vector.
+ * @return Number of bits, 0 on error.
+ */
+size_t vector_bits_len(const uint64_t *bv);
+
+/**
+ * @brief Set the length in bits, growing the capacity if needed. New bits are zero.
+ *
+ * @param bv Bit vector.
+ * @param bits New length in bits.
+ * @return Pointer to the resized bit vector on success, NULL on failure.
+ */
+uint64_t *vector_bits_resize(uint64_t *bv, size_t bits);
+
+/**
+ * @brief Read bit i. Not bounds checked.
+ */
+#define vector_bits_get(bv, i) ((int)(((bv)[(i) >> 6] >> ((i) & 63)) & 1))
+
+/**
+ * @brief Set bit i to one. Not bounds checked.
+ */
+#define vector_bits_set(bv, i) ((bv)[(i) >> 6] |= (uint64_t)1 << ((i) & 63))
+
+/**
+ * @brief Set bit i to zero. Not bounds checked.
+ */
+#define vector_bits_clear(bv, i) ((bv)[(i) >> 6] &= ~((uint64_t)1 << ((i) & 63)))
+
+/**
+ * @brief Append a bit. O(1) amortized.
+ *
+ * Automatically resizes if necessary.
+ *
+ * @param bv Bit vector.
+ * @param bit Zero or nonzero.
+ */
+#define vector_bits_push(bv, bit)                                 \
+    do                                                            \
+    {                                                             \
+        uint64_t *_tmp = internal_vector_bits_push((bv), (bit));  \
+        if (_tmp)                                                 \
+            (bv) = _tmp; /* Resize if needed */                   \
+    } while (0)
+
+/**
+ * @brief dst &= src. Both bit vectors must have the same length.
+ *
+ * @param dst Bit vector updated in place.
+ * @param src Bit vector read.
+ * @return VEC_OK on success, VEC_ERR on error or length mismatch
+ */
+vector_status_t vector_bits_and(uint64_t *dst, const uint64_t *src);
+
+/**
+ * @brief dst |= src. Both bit vectors must have the same length.
+ */
+vector_status_t vector_bits_or(uint64_t *dst, const uint64_t *src);
+
+/**
+ * @brief dst ^= src. Both bit vectors must have the same length.
+ */
+vector_status_t vector_bits_xor(uint64_t *dst, const uint64_t *src);
+
+/**
+ * @brief dst &= ~src. Both bit vectors must have the same length.
+ */
+vector_status_t vector_bits_andnot(uint64_t *dst, const uint64_t *src);
+
+/**
+ * @brief Flip every bit of bv up to its length.
+ *
+ * @param bv Bit vector.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_bits_not(uint64_t *bv);
+
+/**
+ * @brief Count the set bits.
+ *
+ * Uses an AVX2 nibble lookup popcount when the CPU supports it and the
+ * hardware popcount instruction otherwise.
+ *
+ * @param bv Bit vector.
+ * @return Number of set bits, 0 on error.
+ */
+size_t vector_bits_count(const uint64_t *bv);
+
+/**
+ * @brief Position of the first set bit at or after from.
+ *
+ * @param bv Bit vector.
+ * @param from First position to look at.
+ * @return Position of the bit, or the length when there is none.
+ */
+size_t vector_bits_next(const uint64_t *bv, size_t from);
+
+/**
+ * @brief Iterate over the positions of the set bits in increasing order.
+ *
+ * @param _i A size_t variable receiving each position.
+ * @param bv The bit vector.
+ *
+ * Example:
+ * @code
+ * size_t i;
+ * vector_bits_foreach(i, mask) {
+ *     printf("%zu is set\n", i);
+ * }
+ * @endcode
+ */
+#define vector_bits_foreach(_i, bv) \
+    for ((_i) = vector_bits_next((bv), 0); (_i) < vector_bits_len(bv); (_i) = vector_bits_next((bv), (_i) + 1))
+
+/**
+ * @brief Rank/select index over a bit vector.
+ *
+ * Two level counts: one 64-bit entry per 2048 bits holds the ones before it
+ * (relative to its 2^32 bit upper block) and the counts of its first three
+ * 512-bit blocks. Every VECTOR_BITS_SELECT_SAMPLE-th one records its entry
+ * so select only searches between two samples. About 3.5% extra space.
+ *
+ * The index describes the bit vector as it was when built; rebuild it after
+ * changing the bits.
+ */
+typedef struct vector_bits_rank_t vector_bits_rank_t;
+
+/* Ones between two select samples */
+#define VECTOR_BITS_SELECT_SAMPLE 8192
+
+/**
+ * @brief Build a rank/select index. O(n).
+ *
+ * @param bv Bit vector, must outlive the index. Its allocator is used.
+ * @return vector_bits_rank_t* on success, NULL on failure.
+ */
+vector_bits_rank_t *vector_bits_rank_init(const uint64_t *bv);
+
+/**
+ * @brief Free a rank/select index. The bit vector is not touched.
+ *
+ * @param r Index.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_bits_rank_free(vector_bits_rank_t *r);
+
+/**
+ * @brief Number of set bits before position i. O(1).
+ *
+ * @param r Index.
+ * @param i Position, at most the length.
+ * @return Ones in [0, i), 0 on error.
+ */
+size_t vector_bits_rank(const vector_bits_rank_t *r, size_t i);
+
+/**
+ * @brief Position of the set bit with rank k (the first set bit has rank 0).
+ *
+ * @param r Index.
+ * @param k Rank of the wanted set bit.
+ * @return Its position, or the length when there are at most k ones.
+ */
+size_t vector_bits_select(const vector_bits_rank_t *r, size_t k);
+
+/**
+ * @brief Bytes used by the index itself, not counting the bit vector.
+ *
+ * @param r Index.
+ * @return Size in bytes, 0 on error.
+ */
+size_t vector_bits_rank_bytes(const vector_bits_rank_t *r);
+
+/* Internal methdods */
+
+uint64_t *internal_vector_bits_push(uint64_t *bv, int bit);
+
+#endif /* _VECTOR_BITS_H */
@@ -0,0 +1,206 @@
+#include "vector_combinable.h"
+#include "vector_internal.h"
+#include <pthread.h>
+#include <string.h>
+
+/* One cache line per slot so workers growing their vectors never share a line */
+typedef struct
+{
+    void *vec;
+    byte_t pad[VECTOR_CACHE_LINE - sizeof(void *)];
+} vector_combinable_slot_t;
+
+struct vector_combinable_t
+{
+    size_t tsize;
+    size_t count;
+    allocator_t *a;
+    vector_combinable_slot_t *slots; /* follows this struct in the same block */
+};
+
+/* A byte range of the merged output, copied by one thread */
+typedef struct
+{
+    vector_combinable_t *c;
+    byte_t *out;
+    size_t begin, end;
+} vector_combinable_job_t;
+
+/* Round cap up so cap elements fill whole cache lines */
+static size_t vector_combinable_line_cap(size_t tsize, size_t cap)
+{
+    size_t step = VECTOR_CACHE_LINE, t = tsize;
+    if (tsize == 0)
+        return cap;
+    /* step = line / gcd(tsize, line), the smallest element count that fills whole lines */
+    while (t % 2 == 0 && step > 1)
+    {
+        t /= 2;
+        step /= 2;
+    }
+    return (cap + step - 1) / step * step;
+}
+
+static void *vector_combinable_copy(void *arg)
+{
+    vector_combinable_job_t *job = arg;
+    size_t i, pos = 0;
+    for (i = 0; i < job->c->count && pos < job->end; i++)
+    {
+        vector_header_t *hdr = VECTOR_HEADER(job->c->slots[i].vec);
+        size_t n = hdr->len * hdr->tsize;
+        size_t lo = pos > job->begin ? pos : job->begin;
+        size_t hi = pos + n < job->end ? pos + n : job->end;
+        if (lo < hi)
+            memcpy(job->out + lo, (byte_t *)job->c->slots[i].vec + (lo - pos), hi - lo);
+        pos += n;
+    }
+    return NULL;
+}
+
+vector_combinable_t *vector_combinable_init(size_t tsize, size_t slots, allocator_t *a)
+{
+    if (!a || slots == 0)
+    {
+        VECTOR_DEBUG_PERROR("Vector Combinable Init: given null allocator or no slots.\n");
+        return NULL;
+    }
+    size_t head = (sizeof(vector_combinable_t) + VECTOR_CACHE_LINE - 1) / VECTOR_CACHE_LINE * VECTOR_CACHE_LINE;
+    vector_combinable_t *c = a->malloc(head + slots * sizeof(vector_combinable_slot_t));
+    if (!c)
+    {
+        VECTOR_DEBUG_PERROR("Vector Combinable Init: allocation failed.\n");
+        return NULL;
+    }
+    c->tsize = tsize;
+    c->count = slots;
+    c->a = a;
+    c->slots = (vector_combinable_slot_t *)((byte_t *)c + head);
+
+    /* Start each private vector on a cache line and give it whole lines of elements;
+       vector_combinable_push() keeps the rounding when it grows */
+    size_t cap = vector_combinable_line_cap(tsize, VECTOR_DEFAULT_CAP);
+
+    size_t i;
+    for (i = 0; i < slots; i++)
+    {
+        c->slots[i].vec = vector_init_aligned(tsize, cap, VECTOR_CACHE_LINE, a);
+        if (!c->slots[i].vec)
+        {
+            VECTOR_DEBUG_PERROR("Vector Combinable Init: allocation failed.\n");
+            c->count = i;
+            vector_combinable_free(c);
+            return NULL;
+        }
+    }
+    return c;
+}
+
+vector_status_t vector_combinable_free(vector_combinable_t *c)
+{
+    if (!c)
+    {
+        VECTOR_DEBUG_PERROR("Vector Combinable Free: given null.\n");
+        return VEC_ERR;
+    }
+    size_t i;
+    for (i = 0; i < c->count; i++)
+        vector_free(c->slots[i].vec);
+    c->a->free(c);
+    return VEC_OK;
+}
+
+void **vector_combinable_local(vector_combinable_t *c, size_t slot)
+{
+    if (!c || slot >= c->count)
+    {
+        VECTOR_DEBUG_PERROR("Vector Combinable Local: given null or slot out of bounds.\n");
+        return NULL;
+    }
+    return &c->slots[slot].vec;
+}
+
+vector_status_t vector_combinable_push(vector_combinable_t *c, size_t slot, const void *item)
+{
+    if (!c || slot >= c->count || !item)
+    {
+        VECTOR_DEBUG_PERROR("Vector Combinable Push: given null or slot out of bounds.\n");
+        return VEC_ERR;
+    }
+    byte_t *v = c->slots[slot].vec;
+    vector_header_t *hdr = VECTOR_HEADER(v);
+    if (hdr->len == hdr->cap)
+    {
+        v = vector_resize(v, vector_combinable_line_cap(c->tsize, (hdr->cap + 1) * 2));
+        if (!v)
+        {
+            VECTOR_DEBUG_PERROR("Vector Combinable Push: allocation failed.\n");
+            return VEC_ERR;
+        }
+        c->slots[slot].vec = v;
+        hdr = VECTOR_HEADER(v);
+    }
+    memcpy(v + hdr->len * c->tsize, item, c->tsize);
+    hdr->len++;
+    return VEC_OK;
+}
+
+void *vector_combinable_merge(vector_combinable_t *c, size_t threads)
+{
+    if (!c)
+    {
+        VECTOR_DEBUG_PERROR("Vector Combinable Merge: given null.\n");
+        return NULL;
+    }
+    size_t i, total = 0;
+    for (i = 0; i < c->count; i++)
+        total += VECTOR_HEADER(c->slots[i].vec)->len;
+
+    byte_t *out = vector_init(c->tsize, total, c->a);
+    if (!out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Combinable Merge: allocation failed.\n");
+        return NULL;
+    }
+
+    size_t bytes = total * c->tsize;
+    if (threads < 1)
+        threads = 1;
+    if (threads > c->count)
+        threads = c->count; /* more threads than partitions rarely pays off */
+
+    pthread_t *tid = threads > 1 ? c->a->malloc(threads * (sizeof(pthread_t) + sizeof(vector_combinable_job_t))) : NULL;
+    vector_combinable_job_t *jobs = tid ? (vector_combinable_job_t *)(tid + threads) : NULL;
+    if (!tid)
+    {
+        vector_combinable_job_t all = {c, out, 0, bytes};
+        vector_combinable_copy(&all);
+    }
+    else
+    {
+        /* Split the output into equal byte ranges, thread 0 is the caller */
+        for (i = 0; i < threads; i++)
+        {
+            vector_combinable_job_t job = {c, out, bytes / threads * i, i + 1 == threads ? bytes : bytes / threads * (i + 1)};
+            jobs[i] = job;
+        }
+        for (i = 1; i < threads; i++)
+        {
+            if (pthread_create(&tid[i], NULL, vector_combinable_copy, &jobs[i]) != 0)
+            {
+                vector_combinable_copy(&jobs[i]);
+                jobs[i].c = NULL; /* marks not joinable */
+            }
+        }
+        vector_combinable_copy(&jobs[0]);
+        for (i = 1; i < threads; i++)
+            if (jobs[i].c)
+                pthread_join(tid[i], NULL);
+        c->a->free(tid);
+    }
+
+    internal_vector_set_len(out, total);
+    for (i = 0; i < c->count; i++)
+        internal_vector_set_len(c->slots[i].vec, 0);
+    return out;
+}
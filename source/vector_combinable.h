@@ -0,0 +1,91 @@
+#ifndef _VECTOR_COMBINABLE_H
+#define _VECTOR_COMBINABLE_H
+
+#include "vector.h"
+
+/**
+ * @brief A set of private per-thread vectors that merge into one.
+ *
+ * Each worker pushes into its own vailed vector without synchronisation, then
+ * vector_combinable_merge() concatenates them with one exact-size allocation
+ * and a parallel copy. Slot pointers sit on separate cache lines, and each
+ * private vector starts on a cache line with whole lines of elements, so
+ * threads pushing with vector_combinable_push() never write to the same line.
+ */
+typedef struct vector_combinable_t vector_combinable_t;
+
+/**
+ * @brief Create a combinable with one private vector of type T per slot.
+ *
+ * @param T Type of the elements.
+ * @param slots Number of per-thread vectors (usually the worker count).
+ * @param a Pointer to allocator_t.
+ * @return vector_combinable_t* on success, NULL on failure.
+ */
+#define vector_combinable(T, slots, a) vector_combinable_init(sizeof(T), slots, a)
+
+/**
+ * @brief Initialize a combinable.
+ *
+ * @param tsize Size of each element (sizeof(T)).
+ * @param slots Number of per-thread vectors.
+ * @param a Pointer to allocator_t.
+ * @return vector_combinable_t* on success, NULL on failure.
+ */
+vector_combinable_t *vector_combinable_init(size_t tsize, size_t slots, allocator_t *a);
+
+/**
+ * @brief Free a combinable and all per-thread vectors.
+ *
+ * @param c Combinable.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_combinable_free(vector_combinable_t *c);
+
+/**
+ * @brief Address of the private vector for a slot.
+ *
+ * Only one thread may use a slot at a time. The vector may be reallocated by
+ * pushes, so push through the returned address:
+ * @code
+ * int **mine = (int **)vector_combinable_local(c, worker_id);
+ * vector_push_back(*mine, 42);
+ * @endcode
+ * vector_push_back() grows without regard to cache lines, so the tail of a
+ * grown vector may share a line with other memory; vector_combinable_push()
+ * does not.
+ *
+ * @param c Combinable.
+ * @param slot Slot index, below the slot count.
+ * @return Address of the slot's vector pointer, NULL on error.
+ */
+void **vector_combinable_local(vector_combinable_t *c, size_t slot);
+
+/**
+ * @brief Copy one item onto the private vector of a slot.
+ *
+ * Grows the vector to whole cache lines of elements, so the slot never shares
+ * a line with memory written by another thread. Only one thread may use a slot
+ * at a time.
+ *
+ * @param c Combinable.
+ * @param slot Slot index, below the slot count.
+ * @param item Pointer to the item to copy in.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_combinable_push(vector_combinable_t *c, size_t slot, const void *item);
+
+/**
+ * @brief Concatenate all private vectors in slot order into a new vector.
+ *
+ * Allocates the result once at its exact size and copies partitions with up
+ * to threads threads. Private vectors are emptied (capacity is kept).
+ * No thread may push while merging.
+ *
+ * @param c Combinable.
+ * @param threads Copy threads to use, 0 or 1 copies on the calling thread.
+ * @return New vailed vector on success, NULL on failure.
+ */
+void *vector_combinable_merge(vector_combinable_t *c, size_t threads);
+
+#endif /* _VECTOR_COMBINABLE_H */
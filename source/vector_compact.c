@@ -0,0 +1,196 @@
+#include "vector_compact.h"
+#include "vector_internal.h"
+#include <string.h>
+
+typedef struct
+{
+    uint32_t cap;
+    uint32_t len;
+    uint16_t tsize;
+    uint8_t a;         /* allocator registry index */
+    uint8_t reserved;  /* zero */
+    uint32_t padding;  /* keeps the elements 16-byte aligned */
+} vector_compact_header_t;
+
+#define VECTOR_COMPACT_HEADER(vector) ((vector_compact_header_t *)((byte_t *)vector - sizeof(vector_compact_header_t)))
+
+#define VECTOR_COMPACT_MAX_CAP ((size_t)0xffffffffu)
+
+static _Atomic(allocator_t *) registry[VECTOR_ALLOCATOR_SLOTS];
+static atomic_size_t registry_len;
+
+size_t vector_allocator_index(allocator_t *a)
+{
+    if (!a)
+    {
+        VECTOR_DEBUG_PERROR("Vector Allocator Index: given null allocator.\n");
+        return VECTOR_ALLOCATOR_NONE;
+    }
+    for (;;)
+    {
+        size_t n = atomic_load_explicit(&registry_len, memory_order_acquire), i;
+        for (i = 0; i < n; i++)
+        {
+            allocator_t *seen;
+            /* A slot claimed but not yet filled reads as NULL, wait for it */
+            while (!(seen = atomic_load_explicit(&registry[i], memory_order_acquire)))
+                ;
+            if (seen == a)
+                return i;
+        }
+        if (n == VECTOR_ALLOCATOR_SLOTS)
+        {
+            VECTOR_DEBUG_PERROR("Vector Allocator Index: registry full.\n");
+            return VECTOR_ALLOCATOR_NONE;
+        }
+        /* Claim slot n, or rescan if another thread registered meanwhile */
+        if (atomic_compare_exchange_strong_explicit(&registry_len, &n, n + 1, memory_order_acq_rel,
+                                                    memory_order_acquire))
+        {
+            atomic_store_explicit(&registry[n], a, memory_order_release);
+            return n;
+        }
+    }
+}
+
+allocator_t *vector_allocator_at(size_t index)
+{
+    if (index >= VECTOR_ALLOCATOR_SLOTS)
+    {
+        VECTOR_DEBUG_PERROR("Vector Allocator At: index out of bounds.\n");
+        return NULL;
+    }
+    return atomic_load_explicit(&registry[index], memory_order_acquire);
+}
+
+void *vector_compact_init(size_t tsize, size_t cap, allocator_t *a)
+{
+    if (tsize > 0xffff || cap > VECTOR_COMPACT_MAX_CAP)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Init: element size or capacity too large.\n");
+        return NULL;
+    }
+    size_t index = vector_allocator_index(a);
+    if (index == VECTOR_ALLOCATOR_NONE)
+        return NULL;
+    vector_compact_header_t *hdr = a->malloc(sizeof(vector_compact_header_t) + tsize * cap);
+    if (!hdr)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Init: allocation failed.\n");
+        return NULL;
+    }
+    hdr->cap = (uint32_t)cap;
+    hdr->len = 0;
+    hdr->tsize = (uint16_t)tsize;
+    hdr->a = (uint8_t)index;
+    hdr->reserved = 0;
+    hdr->padding = 0;
+    return (byte_t *)hdr + sizeof(vector_compact_header_t);
+}
+
+vector_status_t vector_compact_free(void *vector)
+{
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Free: given null vector.\n");
+        return VEC_ERR;
+    }
+    vector_compact_header_t *hdr = VECTOR_COMPACT_HEADER(vector);
+    vector_allocator_at(hdr->a)->free(hdr);
+    return VEC_OK;
+}
+
+vector_status_t vector_compact_get_len(void *vector, size_t *out)
+{
+    if (!vector || !out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Get Len: given null vector or output pointer.\n");
+        return VEC_ERR;
+    }
+    *out = VECTOR_COMPACT_HEADER(vector)->len;
+    return VEC_OK;
+}
+
+vector_status_t vector_compact_get_cap(void *vector, size_t *out)
+{
+    if (!vector || !out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Get Cap: given null vector or output pointer.\n");
+        return VEC_ERR;
+    }
+    *out = VECTOR_COMPACT_HEADER(vector)->cap;
+    return VEC_OK;
+}
+
+void *vector_compact_resize(void *vector, size_t cap)
+{
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Resize: given null vector.\n");
+        return NULL;
+    }
+    if (cap > VECTOR_COMPACT_MAX_CAP)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Resize: capacity too large.\n");
+        return NULL;
+    }
+    vector_compact_header_t *hdr = VECTOR_COMPACT_HEADER(vector);
+    hdr = vector_allocator_at(hdr->a)->realloc(hdr, sizeof(vector_compact_header_t) + cap * hdr->tsize);
+    if (!hdr)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Resize: realloc failed.\n");
+        return NULL;
+    }
+    hdr->cap = (uint32_t)cap;
+    if (hdr->len > cap)
+        hdr->len = (uint32_t)cap;
+    return (byte_t *)hdr + sizeof(vector_compact_header_t);
+}
+
+void *vector_compact_shrink_to_fit(void *vector)
+{
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Shrink to Fit: given null vector.\n");
+        return NULL;
+    }
+    return vector_compact_resize(vector, VECTOR_COMPACT_HEADER(vector)->len);
+}
+
+vector_status_t vector_compact_pop_back(void *vector, void *out)
+{
+    if (!vector || !out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Pop Back: given null vector or out.\n");
+        return VEC_ERR;
+    }
+    vector_compact_header_t *hdr = VECTOR_COMPACT_HEADER(vector);
+    if (hdr->len == 0)
+        return VEC_EMPTY;
+    hdr->len--;
+    memcpy(out, (byte_t *)vector + (size_t)hdr->len * hdr->tsize, hdr->tsize);
+    return VEC_OK;
+}
+
+void *internal_vector_compact_prepare_push_back(void *vector, size_t *len)
+{
+    if (!vector || !len)
+    {
+        VECTOR_DEBUG_PERROR("Vector Compact Push Back: given null.\n");
+        return NULL;
+    }
+    vector_compact_header_t *hdr = VECTOR_COMPACT_HEADER(vector);
+    if (hdr->len == hdr->cap)
+    {
+        /* Tiny vectors grow by powers of two so none wastes more than half */
+        vector = vector_compact_resize(vector, hdr->cap ? (size_t)hdr->cap * 2 : 1);
+        if (!vector)
+        {
+            VECTOR_DEBUG_PERROR("Vector Compact Push Back: resize failed.\n");
+            return NULL;
+        }
+        hdr = VECTOR_COMPACT_HEADER(vector);
+    }
+    *len = hdr->len++;
+    return vector;
+}
@@ -0,0 +1,135 @@
+#ifndef _VECTOR_COMPACT_H
+#define _VECTOR_COMPACT_H
+
+#include "vector.h"
+
+/* Allocators the registry can hold, compact headers store the index in one byte */
+#define VECTOR_ALLOCATOR_SLOTS 256
+/* Returned by vector_allocator_index() when the registry is full */
+#define VECTOR_ALLOCATOR_NONE ((size_t)-1)
+
+/**
+ * @brief Index of an allocator in the process-wide registry, registering it on first use.
+ *
+ * Registered allocators must stay valid for as long as any vector refers to
+ * them; there is no unregistering. Thread safe.
+ *
+ * @param a Pointer to allocator_t.
+ * @return Its index, VECTOR_ALLOCATOR_NONE if a is NULL or the registry is full.
+ */
+size_t vector_allocator_index(allocator_t *a);
+
+/**
+ * @brief Allocator registered at an index.
+ *
+ * @param index Index from vector_allocator_index().
+ * @return Pointer to allocator_t, NULL if the slot is unused.
+ */
+allocator_t *vector_allocator_at(size_t index);
+
+/*
+ * Compact vectors are vailed vectors with a 16-byte header: 32-bit length and
+ * capacity, a 16-bit element size and a one byte allocator index, against 64
+ * bytes for vector.h. Meant for millions of tiny vectors such as adjacency
+ * lists. They start empty without element storage and grow 1, 2, 4, 8, ...
+ *
+ * They have their own functions; do not pass them to vector.h. There is no
+ * copy-on-write sharing.
+ */
+
+/**
+ * @brief Create an empty compact vector of type T using a specified allocator.
+ *
+ * @param T Type of the elements, at most 65535 bytes.
+ * @param a Pointer to allocator_t.
+ * @return T* Pointer to the start of the vector's elements, NULL on failure.
+ */
+#define vector_compact(T, a) (T *)vector_compact_init(sizeof(T), 0, a)
+
+/**
+ * @brief Initialize a compact vector.
+ *
+ * @param tsize Size of each element, at most 65535.
+ * @param cap Initial capacity, below 2^32.
+ * @param a Pointer to allocator_t, registered with vector_allocator_index().
+ * @return void* Pointer to elements on success, NULL on failure.
+ */
+void *vector_compact_init(size_t tsize, size_t cap, allocator_t *a);
+
+/**
+ * @brief Free a compact vector.
+ *
+ * @param vector Compact vector pointer.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_compact_free(void *vector);
+
+/**
+ * @brief Get the current length.
+ *
+ * @param vector Compact vector pointer.
+ * @param out Pointer to size_t where the length will be written.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_compact_get_len(void *vector, size_t *out);
+
+/**
+ * @brief Get the current capacity.
+ *
+ * @param vector Compact vector pointer.
+ * @param out Pointer to size_t where the capacity will be written.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_compact_get_cap(void *vector, size_t *out);
+
+/**
+ * @brief Resize the capacity, truncating the length if needed.
+ *
+ * @param vector Compact vector pointer.
+ * @param cap New capacity, below 2^32.
+ * @return Pointer to the resized vector on success, NULL on failure.
+ */
+void *vector_compact_resize(void *vector, size_t cap);
+
+/**
+ * @brief Shrink the capacity to the length.
+ *
+ * @param vector Compact vector pointer.
+ * @return Pointer to the resized vector on success, NULL on failure.
+ */
+void *vector_compact_shrink_to_fit(void *vector);
+
+/**
+ * @brief Remove the last element and copy it out.
+ *
+ * @param vector Compact vector pointer.
+ * @param out Receives the element.
+ * @return VEC_OK on success, VEC_EMPTY if the vector is empty, VEC_ERR on error
+ */
+vector_status_t vector_compact_pop_back(void *vector, void *out);
+
+/**
+ * @brief Push an item onto the end of a compact vector.
+ *
+ * Automatically resizes if necessary.
+ *
+ * @param v Compact vector pointer (may be reassigned).
+ * @param item Item to push.
+ */
+#define vector_compact_push_back(v, item)                                   \
+    do                                                                      \
+    {                                                                       \
+        size_t _len;                                                        \
+        void *_tmp = internal_vector_compact_prepare_push_back((v), &_len); \
+        if (!_tmp)                                                          \
+            break;                                                          \
+        (v) = _tmp; /* Resize if needed */                                  \
+        (v)[_len] = (item);                                                 \
+    } while (0)
+
+/* Internal methdods */
+
+/* Makes room for one more element, bumps the length and stores the old one in *len */
+void *internal_vector_compact_prepare_push_back(void *vector, size_t *len);
+
+#endif /* _VECTOR_COMPACT_H */
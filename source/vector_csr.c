@@ -0,0 +1,112 @@
+#include "vector_csr.h"
+#include "vector_internal.h"
+#include <string.h>
+
+vector_status_t vector_flatten_csr(void *rows, size_t tsize, vector_csr_t *out)
+{
+    if (!rows || !out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Flatten CSR: given null argument.\n");
+        return VEC_ERR;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(rows);
+    void **row = rows;
+    size_t n = hdr->len, total = 0, r;
+
+    /* First pass sizes the data exactly and checks the element sizes */
+    for (r = 0; r < n; r++)
+    {
+        if (!row[r])
+            continue;
+        if (VECTOR_HEADER(row[r])->tsize != tsize)
+        {
+            VECTOR_DEBUG_PERROR("Vector Flatten CSR: row element size mismatch.\n");
+            return VEC_ERR;
+        }
+        total += VECTOR_HEADER(row[r])->len;
+    }
+
+    size_t *offsets = vector_init(sizeof(size_t), n + 1, hdr->a);
+    byte_t *data = vector_init(tsize, total, hdr->a);
+    if (!offsets || !data)
+    {
+        VECTOR_DEBUG_PERROR("Vector Flatten CSR: allocation failed.\n");
+        if (offsets)
+            vector_free(offsets);
+        if (data)
+            vector_free(data);
+        return VEC_ERR;
+    }
+    offsets[0] = 0;
+    for (r = 0; r < n; r++)
+    {
+        size_t len = row[r] ? VECTOR_HEADER(row[r])->len : 0;
+        if (len)
+            memcpy(data + offsets[r] * tsize, row[r], len * tsize);
+        offsets[r + 1] = offsets[r] + len;
+    }
+    internal_vector_set_len(offsets, n + 1);
+    internal_vector_set_len(data, total);
+    out->data = data;
+    out->offsets = offsets;
+    out->tsize = tsize;
+    return VEC_OK;
+}
+
+void **vector_unflatten_csr(const vector_csr_t *csr)
+{
+    if (!csr || !csr->data || !csr->offsets)
+    {
+        VECTOR_DEBUG_PERROR("Vector Unflatten CSR: given null or empty form.\n");
+        return NULL;
+    }
+    allocator_t *a = VECTOR_HEADER(csr->data)->a;
+    size_t n = VECTOR_HEADER(csr->offsets)->len - 1, r;
+    void **rows = vector_init(sizeof(void *), n, a);
+    if (!rows)
+    {
+        VECTOR_DEBUG_PERROR("Vector Unflatten CSR: allocation failed.\n");
+        return NULL;
+    }
+    for (r = 0; r < n; r++)
+    {
+        size_t len = vector_csr_row_len(csr, r);
+        rows[r] = vector_init(csr->tsize, len, a);
+        if (!rows[r])
+        {
+            VECTOR_DEBUG_PERROR("Vector Unflatten CSR: allocation failed.\n");
+            while (r-- > 0)
+                vector_free(rows[r]);
+            vector_free(rows);
+            return NULL;
+        }
+        memcpy(rows[r], vector_csr_row(csr, r), len * csr->tsize);
+        internal_vector_set_len(rows[r], len);
+    }
+    internal_vector_set_len(rows, n);
+    return rows;
+}
+
+vector_status_t vector_csr_free(vector_csr_t *csr)
+{
+    if (!csr || !csr->data || !csr->offsets)
+    {
+        VECTOR_DEBUG_PERROR("Vector CSR Free: given null or empty form.\n");
+        return VEC_ERR;
+    }
+    vector_free(csr->data);
+    vector_free(csr->offsets);
+    csr->data = NULL;
+    csr->offsets = NULL;
+    return VEC_OK;
+}
+
+size_t internal_vector_csr_len(const size_t *offsets)
+{
+    if (!offsets)
+    {
+        VECTOR_DEBUG_PERROR("Vector CSR Rows: given null offsets.\n");
+        return 1;
+    }
+    return VECTOR_HEADER(offsets)->len;
+}
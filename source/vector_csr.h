@@ -0,0 +1,85 @@
+#ifndef _VECTOR_CSR_H
+#define _VECTOR_CSR_H
+
+#include "vector.h"
+
+/**
+ * @brief Vector of vectors packed in compressed sparse row form.
+ *
+ * Every row is stored back to back in one data vector; row r is
+ * data[offsets[r] .. offsets[r + 1]). Both members are regular vailed
+ * vectors: offsets holds rows + 1 size_t entries starting at 0. Walking rows
+ * in order streams both arrays with no pointer chasing and no per-row header.
+ */
+typedef struct
+{
+    void *data;      /* all elements, row after row */
+    size_t *offsets; /* rows + 1 entries */
+    size_t tsize;    /* element size */
+} vector_csr_t;
+
+/**
+ * @brief Pack a vector of vectors into CSR form. O(total elements).
+ *
+ * @param rows Vailed vector whose elements are vailed vectors (NULL rows count as empty).
+ * @param tsize Element size of the inner vectors, checked against each of them.
+ * @param out Receives the packed form, allocated with the outer vector's allocator.
+ * @return VEC_OK on success, VEC_ERR on error or element size mismatch
+ */
+vector_status_t vector_flatten_csr(void *rows, size_t tsize, vector_csr_t *out);
+
+/**
+ * @brief Unpack CSR form into a new vector of vectors, each row sized to fit.
+ *
+ * @param csr Packed form.
+ * @return Vailed vector of vailed vectors on success, NULL on failure.
+ */
+void **vector_unflatten_csr(const vector_csr_t *csr);
+
+/**
+ * @brief Free both vectors of a packed form.
+ *
+ * @param csr Packed form.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_csr_free(vector_csr_t *csr);
+
+/**
+ * @brief Number of rows.
+ */
+#define vector_csr_rows(csr) (internal_vector_csr_len((csr)->offsets) - 1)
+
+/**
+ * @brief Pointer to the first element of row r. Not bounds checked.
+ */
+#define vector_csr_row(csr, r) ((void *)((unsigned char *)(csr)->data + (csr)->offsets[r] * (csr)->tsize))
+
+/**
+ * @brief Number of elements in row r. Not bounds checked.
+ */
+#define vector_csr_row_len(csr, r) ((csr)->offsets[(r) + 1] - (csr)->offsets[r])
+
+/**
+ * @brief Iterate over the elements of row r through a typed pointer.
+ *
+ * @param _p A pointer variable of the element type receiving each element's address.
+ * @param csr Pointer to the packed form.
+ * @param r Row index.
+ *
+ * Example:
+ * @code
+ * size_t r;
+ * int *p;
+ * for (r = 0; r < vector_csr_rows(&g); r++)
+ *     vector_csr_foreach(p, &g, r)
+ *         visit(r, *p);
+ * @endcode
+ */
+#define vector_csr_foreach(_p, csr, r) \
+    for ((_p) = vector_csr_row((csr), (r)); (void *)(_p) != vector_csr_row((csr), (r) + 1); ++(_p))
+
+/* Internal methdods */
+
+size_t internal_vector_csr_len(const size_t *offsets);
+
+#endif /* _VECTOR_CSR_H */
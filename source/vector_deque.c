@@ -0,0 +1,241 @@
+#include "vector_deque.h"
+#include "vector_internal.h"
+#include <string.h>
+
+/* The vector header sits directly in front of the storage so the generic
+ * vector getters keep working; the head offset is stored before it. */
+typedef struct
+{
+    size_t head;         /* physical index of the front element */
+    size_t reserved;     /* keeps the storage 16-byte aligned */
+    vector_header_t vec; /* cap, len, tsize, allocator */
+} vector_deque_header_t;
+
+#define VECTOR_DEQUE_HEADER(deque) ((vector_deque_header_t *)((byte_t *)deque - sizeof(vector_deque_header_t)))
+
+/* Reverse the elements in [lo, hi) in place */
+static void vector_deque_reverse(byte_t *base, size_t tsize, size_t lo, size_t hi)
+{
+    while (hi > lo + 1)
+    {
+        byte_t *x = base + lo * tsize;
+        byte_t *y = base + (hi - 1) * tsize;
+        size_t k;
+        for (k = 0; k < tsize; k++)
+        {
+            byte_t t = x[k];
+            x[k] = y[k];
+            y[k] = t;
+        }
+        lo++;
+        hi--;
+    }
+}
+
+/* Initialize a new deque */
+void *vector_deque_init(size_t tsize, size_t cap, allocator_t *a)
+{
+    if (!a)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Init: given null allocator.\n");
+        return NULL;
+    }
+    vector_deque_header_t *hdr = a->malloc(sizeof(vector_deque_header_t) + tsize * cap);
+    if (!hdr)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Init: allocation failed.\n");
+        return NULL;
+    }
+    hdr->head = 0;
+    hdr->reserved = 0;
+    internal_vector_header_init(&hdr->vec, tsize, cap, a);
+    return (byte_t *)hdr + sizeof(vector_deque_header_t);
+}
+
+/* Free a deque */
+vector_status_t vector_deque_free(void *deque)
+{
+    if (!deque)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Free: given null deque.\n");
+        return VEC_ERR;
+    }
+    vector_deque_header_t *hdr = VECTOR_DEQUE_HEADER(deque);
+    if (!hdr->vec.a)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Free: null allocator in header.\n");
+        return VEC_ERR;
+    }
+    hdr->vec.a->free(hdr);
+    return VEC_OK;
+}
+
+/* Rotate elements to the start of the storage */
+void *vector_deque_linearize(void *deque)
+{
+    if (!deque)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Linearize: given null deque.\n");
+        return NULL;
+    }
+    vector_deque_header_t *hdr = VECTOR_DEQUE_HEADER(deque);
+    size_t tsize = hdr->vec.tsize;
+
+    if (hdr->head == 0)
+        return deque;
+
+    if (hdr->head + hdr->vec.len <= hdr->vec.cap)
+    {
+        /* Contiguous, just slide it down */
+        memmove(deque, (byte_t *)deque + hdr->head * tsize, hdr->vec.len * tsize);
+    }
+    else
+    {
+        /* Wrapped: rotate the whole storage left by head */
+        vector_deque_reverse(deque, tsize, 0, hdr->head);
+        vector_deque_reverse(deque, tsize, hdr->head, hdr->vec.cap);
+        vector_deque_reverse(deque, tsize, 0, hdr->vec.cap);
+    }
+
+    hdr->head = 0;
+    return deque;
+}
+
+/* Resize deque capacity */
+void *vector_deque_resize(void *deque, size_t cap)
+{
+    if (!deque)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Resize: given null deque.\n");
+        return NULL;
+    }
+    vector_deque_header_t *hdr = VECTOR_DEQUE_HEADER(deque);
+    if (!hdr->vec.a)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Resize: null allocator in header.\n");
+        return NULL;
+    }
+    if (cap < hdr->vec.len)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Resize: capacity smaller than length.\n");
+        return NULL;
+    }
+
+    size_t old_cap = hdr->vec.cap;
+    size_t tsize = hdr->vec.tsize;
+
+    /* Shrinking may cut into the wrapped part, so unwrap first */
+    if (cap < old_cap)
+        vector_deque_linearize(deque);
+
+    vector_deque_header_t *new_hdr = hdr->vec.a->realloc(hdr, sizeof(vector_deque_header_t) + cap * tsize);
+    if (!new_hdr)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Resize: realloc failed.\n");
+        return NULL;
+    }
+    byte_t *data = (byte_t *)new_hdr + sizeof(vector_deque_header_t);
+
+    if (new_hdr->head + new_hdr->vec.len > old_cap)
+    {
+        /* Growing a wrapped deque: move the front run to the new end */
+        size_t run = old_cap - new_hdr->head;
+        memmove(data + (cap - run) * tsize, data + new_hdr->head * tsize, run * tsize);
+        new_hdr->head = cap - run;
+    }
+
+    new_hdr->vec.cap = cap;
+    return data;
+}
+
+/* Pop front: advance head and copy out the old front */
+vector_status_t vector_deque_pop_front(void *deque, void *out)
+{
+    if (!deque || !out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Pop Front: given null deque or out.\n");
+        return VEC_ERR;
+    }
+    vector_deque_header_t *hdr = VECTOR_DEQUE_HEADER(deque);
+    if (hdr->vec.len == 0)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Pop Front: empty deque.\n");
+        return VEC_EMPTY;
+    }
+    memcpy(out, (byte_t *)deque + hdr->head * hdr->vec.tsize, hdr->vec.tsize);
+    if (++hdr->head == hdr->vec.cap)
+        hdr->head = 0;
+    if (--hdr->vec.len == 0)
+        hdr->head = 0;
+    return VEC_OK;
+}
+
+/* Pop back: reduce length and copy out the old back */
+vector_status_t vector_deque_pop_back(void *deque, void *out)
+{
+    if (!deque || !out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Pop Back: given null deque or out.\n");
+        return VEC_ERR;
+    }
+    vector_deque_header_t *hdr = VECTOR_DEQUE_HEADER(deque);
+    if (hdr->vec.len == 0)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Pop Back: empty deque.\n");
+        return VEC_EMPTY;
+    }
+    hdr->vec.len--;
+    memcpy(out, (byte_t *)deque + internal_vector_deque_index(deque, hdr->vec.len) * hdr->vec.tsize, hdr->vec.tsize);
+    if (hdr->vec.len == 0)
+        hdr->head = 0;
+    return VEC_OK;
+}
+
+void *internal_vector_deque_prepare_push(void *deque)
+{
+    if (!deque)
+    {
+        VECTOR_DEBUG_PERROR("Vector Deque Push: given null.\n");
+        return NULL;
+    }
+
+    vector_deque_header_t *hdr = VECTOR_DEQUE_HEADER(deque);
+    if (hdr->vec.len == hdr->vec.cap)
+    {
+        void *tmp = vector_deque_resize(deque, (hdr->vec.cap + 1) * 2);
+        if (!tmp)
+        {
+            VECTOR_DEBUG_PERROR("Vector Deque Push: resize failed.\n");
+            return NULL;
+        }
+        deque = tmp;
+    }
+
+    return deque;
+}
+
+/* Reserve a slot at either end (capacity must be available) and return its physical index */
+size_t internal_vector_deque_claim(void *deque, int front)
+{
+    vector_deque_header_t *hdr = VECTOR_DEQUE_HEADER(deque);
+    size_t slot;
+    if (front)
+    {
+        hdr->head = (hdr->head == 0 ? hdr->vec.cap : hdr->head) - 1;
+        slot = hdr->head;
+    }
+    else
+    {
+        slot = internal_vector_deque_index(deque, hdr->vec.len);
+    }
+    hdr->vec.len++;
+    return slot;
+}
+
+/* Map a logical index to a physical one (no bounds check) */
+size_t internal_vector_deque_index(void *deque, size_t index)
+{
+    vector_deque_header_t *hdr = VECTOR_DEQUE_HEADER(deque);
+    size_t pos = hdr->head + index;
+    return pos >= hdr->vec.cap ? pos - hdr->vec.cap : pos;
+}
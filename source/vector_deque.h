@@ -0,0 +1,124 @@
+#ifndef _VECTOR_DEQUE_H
+#define _VECTOR_DEQUE_H
+
+#include "vector.h"
+
+/**
+ * @brief Create a new double ended queue of type T using a specified allocator.
+ *
+ * A deque is a vailed ring buffer: the returned pointer addresses the element
+ * storage and the header (capacity, length and head offset) lives in front of it.
+ * Elements wrap around the capacity, so index them with vector_deque_at() rather
+ * than directly. vector_get_len() and vector_get_cap() work on deques.
+ *
+ * @param T Type of the elements.
+ * @param a Pointer to allocator_t.
+ * @return T* Pointer to the start of the deque's storage.
+ */
+#define vector_deque(T, a) (T *)vector_deque_init(sizeof(T), VECTOR_DEFAULT_CAP, a)
+
+/**
+ * @brief Initialize a deque.
+ *
+ * @param tsize Size of each element (sizeof(T)).
+ * @param cap Initial capacity.
+ * @param a Pointer to allocator_t.
+ * @return void* Pointer to storage on success, NULL on failure.
+ */
+void *vector_deque_init(size_t tsize, size_t cap, allocator_t *a);
+
+/**
+ * @brief Free a deque. Must be used instead of vector_free().
+ *
+ * @param deque Deque pointer.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_deque_free(void *deque);
+
+/**
+ * @brief Resize the deque to a new capacity, unwrapping its elements.
+ *
+ * @param deque Deque pointer.
+ * @param cap New capacity, must be at least the current length.
+ * @return Pointer to resized deque on success, NULL on failure.
+ */
+void *vector_deque_resize(void *deque, size_t cap);
+
+/**
+ * @brief Removes the first element of the deque and copies it to out. O(1).
+ *
+ * @param deque Deque pointer.
+ * @param out Reference to copy popped value to.
+ * @return VEC_OK on success, VEC_EMPTY if empty, VEC_ERR on error
+ */
+vector_status_t vector_deque_pop_front(void *deque, void *out);
+
+/**
+ * @brief Removes the last element of the deque and copies it to out. O(1).
+ *
+ * @param deque Deque pointer.
+ * @param out Reference to copy popped value to.
+ * @return VEC_OK on success, VEC_EMPTY if empty, VEC_ERR on error
+ */
+vector_status_t vector_deque_pop_back(void *deque, void *out);
+
+/**
+ * @brief Rotates the elements so the first one is at the start of the storage.
+ *
+ * After this call the deque pointer can be read as a plain vailed array:
+ * element i is at deque[i] and vector_get_len(), vector_foreach() and
+ * vector_normal_copy() behave as for a vector. It must still be freed with
+ * vector_deque_free(). Runs in place, O(1) if already linear, O(n) otherwise.
+ *
+ * @param deque Deque pointer.
+ * @return The same deque pointer on success, NULL on failure.
+ */
+void *vector_deque_linearize(void *deque);
+
+/**
+ * @brief Access element at logical index i of the deque (lvalue).
+ *
+ * @param d Deque pointer.
+ * @param i Logical index, 0 is the front. Not bounds checked.
+ */
+#define vector_deque_at(d, i) ((d)[internal_vector_deque_index((d), (i))])
+
+/**
+ * @brief Push an item onto the end of the deque. O(1) amortized.
+ *
+ * Automatically resizes if necessary.
+ *
+ * @param d Deque pointer.
+ * @param item Item to push.
+ */
+#define vector_deque_push_back(d, item) internal_vector_deque_push(d, item, 0)
+
+/**
+ * @brief Push an item onto the front of the deque. O(1) amortized.
+ *
+ * Automatically resizes if necessary.
+ *
+ * @param d Deque pointer.
+ * @param item Item to push.
+ */
+#define vector_deque_push_front(d, item) internal_vector_deque_push(d, item, 1)
+
+/* Internal methdods */
+
+void *internal_vector_deque_prepare_push(void *deque);
+
+size_t internal_vector_deque_claim(void *deque, int front);
+
+size_t internal_vector_deque_index(void *deque, size_t index);
+
+#define internal_vector_deque_push(d, item, front)                \
+    do                                                            \
+    {                                                             \
+        void *_tmp = internal_vector_deque_prepare_push((d));     \
+        if (!_tmp)                                                \
+            break;                                                \
+        (d) = _tmp; /* Resize if needed */                        \
+        (d)[internal_vector_deque_claim((d), (front))] = (item); \
+    } while (0)
+
+#endif /* _VECTOR_DEQUE_H */
@@ -0,0 +1,429 @@
+#include "vector_hash.h"
+#include "vector_internal.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define VECTOR_HASH_SSE2 1
+#endif
+
+/* Control bytes: 0..127 is a full slot holding the low 7 hash bits */
+#define VECTOR_HASH_EMPTY ((signed char)-128)
+#define VECTOR_HASH_DELETED ((signed char)-2)
+
+#define VECTOR_HASH_MIN_CAP VECTOR_HASH_GROUP
+
+#if defined(__GNUC__)
+#define VECTOR_HASH_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define VECTOR_HASH_PREFETCH(p) ((void)0)
+#endif
+
+struct vector_hash_t
+{
+    signed char *ctrl; /* cap + GROUP - 1 bytes, the first GROUP - 1 mirrored at the end */
+    byte_t *slots;     /* cap slots of stride bytes, the value voff bytes after the key */
+    size_t mask;       /* cap - 1 */
+    size_t len;
+    size_t growth; /* inserts into empty slots left before a rehash */
+    size_t ksize;
+    size_t vsize;
+    size_t voff;
+    size_t stride;
+    size_t (*hash)(const void *);
+    int (*cmp)(const void *, const void *);
+    allocator_t *a;
+};
+
+static size_t vector_hash_ctz(unsigned x)
+{
+#if defined(__GNUC__)
+    return (size_t)__builtin_ctz(x);
+#else
+    size_t r = 0;
+    while (!(x & 1))
+    {
+        x >>= 1;
+        r++;
+    }
+    return r;
+#endif
+}
+
+static size_t vector_hash_log2(unsigned x)
+{
+#if defined(__GNUC__)
+    return sizeof(unsigned) * 8 - 1 - __builtin_clz(x);
+#else
+    size_t r = 0;
+    while (x >>= 1)
+        r++;
+    return r;
+#endif
+}
+
+/* Bit i set when control byte i of the group equals c */
+static unsigned vector_hash_match(const signed char *g, signed char c)
+{
+#ifdef VECTOR_HASH_SSE2
+    __m128i x = _mm_loadu_si128((const __m128i *)g);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8(c)));
+#else
+    unsigned m = 0, i;
+    for (i = 0; i < VECTOR_HASH_GROUP; i++)
+        m |= (unsigned)(g[i] == c) << i;
+    return m;
+#endif
+}
+
+/* Bit i set when slot i of the group is empty or deleted, the sign bit of its control byte */
+static unsigned vector_hash_match_free(const signed char *g)
+{
+#ifdef VECTOR_HASH_SSE2
+    return (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)g));
+#else
+    unsigned m = 0, i;
+    for (i = 0; i < VECTOR_HASH_GROUP; i++)
+        m |= (unsigned)(g[i] < 0) << i;
+    return m;
+#endif
+}
+
+/* Elements a table of cap slots holds before it grows */
+static size_t vector_hash_max_load(size_t cap)
+{
+    return cap - cap / 8;
+}
+
+/* Alignment a member of this size can rely on, capped at 16 */
+static size_t vector_hash_align_of(size_t size)
+{
+    size_t align = 1;
+    if (size == 0)
+        return 1;
+    while (align < 16 && size % (align * 2) == 0)
+        align *= 2;
+    return align;
+}
+
+static void vector_hash_set_ctrl(vector_hash_t *h, size_t i, signed char c)
+{
+    h->ctrl[i] = c;
+    /* Same byte when i >= GROUP - 1, its mirror past the end otherwise */
+    h->ctrl[((i - (VECTOR_HASH_GROUP - 1)) & h->mask) + (VECTOR_HASH_GROUP - 1)] = c;
+}
+
+/*
+ * Groups are probed at offsets 0, 1, 3, 6, ... times the group width. With a
+ * power of two number of slots this reaches every slot, and the table always
+ * keeps an empty one, so the loops end.
+ */
+
+/* Slot holding key, or the capacity when absent */
+static size_t vector_hash_lookup(const vector_hash_t *h, const void *key, size_t hash)
+{
+    size_t pos = (hash >> 7) & h->mask, step = 0;
+    signed char tag = (signed char)(hash & 0x7f);
+    /* Most keys sit at or near their home slot, fetch it while the group is compared */
+    VECTOR_HASH_PREFETCH(h->slots + pos * h->stride);
+    for (;;)
+    {
+        const signed char *g = h->ctrl + pos;
+        unsigned m = vector_hash_match(g, tag);
+        while (m)
+        {
+            size_t i = (pos + vector_hash_ctz(m)) & h->mask;
+            if (h->cmp(h->slots + i * h->stride, key) == 0)
+                return i;
+            m &= m - 1;
+        }
+        if (vector_hash_match(g, VECTOR_HASH_EMPTY))
+            return h->mask + 1;
+        step += VECTOR_HASH_GROUP;
+        pos = (pos + step) & h->mask;
+    }
+}
+
+/* First empty or deleted slot on the probe sequence of hash */
+static size_t vector_hash_find_free(const vector_hash_t *h, size_t hash)
+{
+    size_t pos = (hash >> 7) & h->mask, step = 0;
+    for (;;)
+    {
+        unsigned m = vector_hash_match_free(h->ctrl + pos);
+        if (m)
+            return (pos + vector_hash_ctz(m)) & h->mask;
+        step += VECTOR_HASH_GROUP;
+        pos = (pos + step) & h->mask;
+    }
+}
+
+/* Move every element into fresh arrays of cap slots */
+static vector_status_t vector_hash_resize(vector_hash_t *h, size_t cap)
+{
+    signed char *ctrl = vector_init_aligned(1, cap + VECTOR_HASH_GROUP - 1, VECTOR_CACHE_LINE, h->a);
+    byte_t *slots = vector_init(h->stride, cap, h->a);
+    if (!ctrl || !slots)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Resize: allocation failed.\n");
+        if (ctrl)
+            vector_free(ctrl);
+        if (slots)
+            vector_free(slots);
+        return VEC_ERR;
+    }
+    memset(ctrl, VECTOR_HASH_EMPTY, cap + VECTOR_HASH_GROUP - 1);
+    internal_vector_set_len(ctrl, cap + VECTOR_HASH_GROUP - 1);
+    internal_vector_set_len(slots, cap);
+
+    signed char *old_ctrl = h->ctrl;
+    byte_t *old_slots = h->slots;
+    size_t old_cap = old_ctrl ? h->mask + 1 : 0, i;
+    h->ctrl = ctrl;
+    h->slots = slots;
+    h->mask = cap - 1;
+    for (i = 0; i < old_cap; i++)
+    {
+        if (old_ctrl[i] < 0)
+            continue;
+        const byte_t *item = old_slots + i * h->stride;
+        size_t hash = h->hash(item);
+        size_t j = vector_hash_find_free(h, hash);
+        vector_hash_set_ctrl(h, j, (signed char)(hash & 0x7f));
+        memcpy(slots + j * h->stride, item, h->stride);
+    }
+    h->growth = vector_hash_max_load(cap) - h->len;
+    if (old_ctrl)
+    {
+        vector_free(old_ctrl);
+        vector_free(old_slots);
+    }
+    return VEC_OK;
+}
+
+/* Smallest table holding n elements */
+static size_t vector_hash_cap_for(size_t n)
+{
+    size_t cap = VECTOR_HASH_MIN_CAP;
+    while (vector_hash_max_load(cap) < n)
+        cap *= 2;
+    return cap;
+}
+
+vector_hash_t *vector_hash_init(size_t ksize, size_t vsize, size_t (*hash)(const void *),
+                                int (*cmp)(const void *, const void *), allocator_t *a)
+{
+    if (!hash || !cmp || !a)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Init: given null argument.\n");
+        return NULL;
+    }
+    if (ksize == 0)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Init: key size is zero.\n");
+        return NULL;
+    }
+    vector_hash_t *h = a->malloc(sizeof(vector_hash_t));
+    if (!h)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Init: allocation failed.\n");
+        return NULL;
+    }
+    size_t kalign = vector_hash_align_of(ksize), valign = vector_hash_align_of(vsize);
+    size_t align = kalign > valign ? kalign : valign;
+    memset(h, 0, sizeof(*h));
+    h->ksize = ksize;
+    h->vsize = vsize;
+    h->voff = (ksize + valign - 1) / valign * valign;
+    h->stride = (h->voff + vsize + align - 1) / align * align;
+    h->hash = hash;
+    h->cmp = cmp;
+    h->a = a;
+    if (vector_hash_resize(h, VECTOR_HASH_MIN_CAP) != VEC_OK)
+    {
+        a->free(h);
+        return NULL;
+    }
+    return h;
+}
+
+vector_status_t vector_hash_free(vector_hash_t *h)
+{
+    if (!h)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Free: given null hash map.\n");
+        return VEC_ERR;
+    }
+    vector_free(h->ctrl);
+    vector_free(h->slots);
+    h->a->free(h);
+    return VEC_OK;
+}
+
+size_t vector_hash_len(const vector_hash_t *h)
+{
+    if (!h)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Len: given null hash map.\n");
+        return 0;
+    }
+    return h->len;
+}
+
+size_t vector_hash_cap(const vector_hash_t *h)
+{
+    if (!h)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Cap: given null hash map.\n");
+        return 0;
+    }
+    return h->mask + 1;
+}
+
+void *vector_hash_find(const vector_hash_t *h, const void *key)
+{
+    if (!h || !key)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Find: given null argument.\n");
+        return NULL;
+    }
+    size_t i = vector_hash_lookup(h, key, h->hash(key));
+    if (i > h->mask)
+        return NULL;
+    return h->slots + i * h->stride + (h->vsize ? h->voff : 0);
+}
+
+void *vector_hash_insert(vector_hash_t *h, const void *key, const void *value)
+{
+    if (!h || !key)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Insert: given null argument.\n");
+        return NULL;
+    }
+    size_t hash = h->hash(key);
+    size_t i = vector_hash_lookup(h, key, hash);
+    if (i > h->mask)
+    {
+        i = vector_hash_find_free(h, hash);
+        /* Reusing a tombstone costs no growth */
+        if (h->growth == 0 && h->ctrl[i] == VECTOR_HASH_EMPTY)
+        {
+            /* Mostly tombstones: rebuild at the same size instead of growing */
+            size_t cap = h->mask + 1;
+            if (h->len >= vector_hash_max_load(cap) / 2)
+                cap *= 2;
+            if (vector_hash_resize(h, cap) != VEC_OK)
+                return NULL;
+            i = vector_hash_find_free(h, hash);
+        }
+        if (h->ctrl[i] == VECTOR_HASH_EMPTY)
+            h->growth--;
+        vector_hash_set_ctrl(h, i, (signed char)(hash & 0x7f));
+        memcpy(h->slots + i * h->stride, key, h->ksize);
+        if (!value)
+            memset(h->slots + i * h->stride + h->voff, 0, h->vsize);
+        h->len++;
+    }
+    byte_t *item = h->slots + i * h->stride;
+    if (value)
+        memcpy(item + h->voff, value, h->vsize);
+    return h->vsize ? item + h->voff : item;
+}
+
+vector_status_t vector_hash_erase(vector_hash_t *h, const void *key)
+{
+    if (!h || !key)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Erase: given null argument.\n");
+        return VEC_ERR;
+    }
+    size_t i = vector_hash_lookup(h, key, h->hash(key));
+    if (i > h->mask)
+        return VEC_INDEX_OOB;
+
+    /*
+     * A probe only moves past a group with no empty slot. If the runs of
+     * non-empty bytes on both sides of i span less than a group, no window
+     * covering i was ever full and the slot can become empty again.
+     */
+    unsigned before = vector_hash_match(h->ctrl + ((i - VECTOR_HASH_GROUP) & h->mask), VECTOR_HASH_EMPTY);
+    unsigned after = vector_hash_match(h->ctrl + i, VECTOR_HASH_EMPTY);
+    if (before && after &&
+        (VECTOR_HASH_GROUP - 1 - vector_hash_log2(before)) + vector_hash_ctz(after) < VECTOR_HASH_GROUP)
+    {
+        vector_hash_set_ctrl(h, i, VECTOR_HASH_EMPTY);
+        h->growth++;
+    }
+    else
+    {
+        vector_hash_set_ctrl(h, i, VECTOR_HASH_DELETED);
+    }
+    h->len--;
+    return VEC_OK;
+}
+
+vector_status_t vector_hash_reserve(vector_hash_t *h, size_t n)
+{
+    if (!h)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Reserve: given null hash map.\n");
+        return VEC_ERR;
+    }
+    if (n <= h->len + h->growth)
+        return VEC_OK;
+    size_t cap = vector_hash_cap_for(n);
+    return vector_hash_resize(h, cap > h->mask + 1 ? cap : h->mask + 1);
+}
+
+vector_status_t vector_hash_rehash(vector_hash_t *h, size_t n)
+{
+    if (!h)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Rehash: given null hash map.\n");
+        return VEC_ERR;
+    }
+    return vector_hash_resize(h, vector_hash_cap_for(n > h->len ? n : h->len));
+}
+
+size_t vector_hash_next(const vector_hash_t *h, size_t from)
+{
+    if (!h)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Next: given null hash map.\n");
+        return 0;
+    }
+    while (from <= h->mask && h->ctrl[from] < 0)
+        from++;
+    return from;
+}
+
+void *vector_hash_key(const vector_hash_t *h, size_t slot)
+{
+    if (!h || slot > h->mask)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Key: given null hash map or slot out of bounds.\n");
+        return NULL;
+    }
+    return h->slots + slot * h->stride;
+}
+
+void *vector_hash_value(const vector_hash_t *h, size_t slot)
+{
+    if (!h || slot > h->mask)
+    {
+        VECTOR_DEBUG_PERROR("Vector Hash Value: given null hash map or slot out of bounds.\n");
+        return NULL;
+    }
+    return h->slots + slot * h->stride + (h->vsize ? h->voff : 0);
+}
+
+size_t vector_hash_u64(const void *key)
+{
+    uint64_t x = *(const uint64_t *)key;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return (size_t)x;
+}
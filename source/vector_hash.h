@@ -0,0 +1,169 @@
+#ifndef _VECTOR_HASH_H
+#define _VECTOR_HASH_H
+
+#include "vector.h"
+
+/* Control bytes probed at once, one SSE2 register */
+#define VECTOR_HASH_GROUP 16
+
+/**
+ * @brief Open addressing flat hash map (Swiss table layout).
+ *
+ * Keys and values are copied into one vailed vector of slots. A parallel
+ * vailed vector of control bytes holds 7 bits of each occupant's hash, so a
+ * lookup compares a whole group of VECTOR_HASH_GROUP candidates with one SIMD
+ * compare and only calls the comparator on likely matches. Probing moves
+ * group by group and stops at the first group with an empty slot.
+ *
+ * The table holds at most 7/8 of its capacity. Erasing leaves a tombstone
+ * only when a probe may have passed the slot while it was full. Inserting
+ * may rehash, which moves every element: pointers returned by
+ * vector_hash_find() and vector_hash_insert() stay valid only until the next
+ * insert.
+ */
+typedef struct vector_hash_t vector_hash_t;
+
+/**
+ * @brief Create an empty hash map from keys of type K to values of type V.
+ *
+ * @param K Key type.
+ * @param V Value type.
+ * @param hash Hash function, see vector_hash_init().
+ * @param cmp Key comparator, see vector_hash_init().
+ * @param a Pointer to allocator_t.
+ * @return vector_hash_t* on success, NULL on failure.
+ */
+#define vector_hash(K, V, hash, cmp, a) vector_hash_init(sizeof(K), sizeof(V), (hash), (cmp), (a))
+
+/**
+ * @brief Create an empty hash map.
+ *
+ * @param ksize Size of each key.
+ * @param vsize Size of each value, 0 for a set.
+ * @param hash Hash of the key pointed to. All bits are used, so it must mix well.
+ * @param cmp Key comparator, only compared against zero: 0 means equal keys.
+ * @param a Pointer to allocator_t, used for the control bytes and the slots.
+ * @return vector_hash_t* on success, NULL on failure.
+ */
+vector_hash_t *vector_hash_init(size_t ksize, size_t vsize, size_t (*hash)(const void *),
+                                int (*cmp)(const void *, const void *), allocator_t *a);
+
+/**
+ * @brief Free a hash map.
+ *
+ * @param h Hash map.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_hash_free(vector_hash_t *h);
+
+/**
+ * @brief Number of elements.
+ *
+ * @param h Hash map.
+ * @return Number of elements, 0 on error.
+ */
+size_t vector_hash_len(const vector_hash_t *h);
+
+/**
+ * @brief Number of slots, a power of two.
+ *
+ * @param h Hash map.
+ * @return Number of slots, 0 on error.
+ */
+size_t vector_hash_cap(const vector_hash_t *h);
+
+/**
+ * @brief Pointer to the value stored for key.
+ *
+ * @param h Hash map.
+ * @param key Pointer to the key.
+ * @return Pointer to the value (to the key for a set), NULL if absent or on error.
+ */
+void *vector_hash_find(const vector_hash_t *h, const void *key);
+
+/**
+ * @brief Insert a copy of key and value, or overwrite the value of an equal key.
+ *
+ * Grows the table when it is full.
+ *
+ * @param h Hash map.
+ * @param key Pointer to the key.
+ * @param value Pointer to the value, NULL to leave a new value zeroed and an old one unchanged.
+ * @return Pointer to the stored value (to the key for a set), NULL on failure.
+ */
+void *vector_hash_insert(vector_hash_t *h, const void *key, const void *value);
+
+/**
+ * @brief Remove the element with key.
+ *
+ * @param h Hash map.
+ * @param key Pointer to the key.
+ * @return VEC_OK on success, VEC_INDEX_OOB if key is absent, VEC_ERR on error
+ */
+vector_status_t vector_hash_erase(vector_hash_t *h, const void *key);
+
+/**
+ * @brief Make room for n elements in total without rehashing on insert.
+ *
+ * @param h Hash map.
+ * @param n Number of elements.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_hash_reserve(vector_hash_t *h, size_t n);
+
+/**
+ * @brief Rebuild the table for at least n elements, dropping every tombstone.
+ *
+ * Shrinks the table when n is below the current capacity, never below the length.
+ *
+ * @param h Hash map.
+ * @param n Number of elements, 0 for the smallest table holding the current ones.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_hash_rehash(vector_hash_t *h, size_t n);
+
+/**
+ * @brief Slot of the first element at or after slot from.
+ *
+ * @param h Hash map.
+ * @param from First slot to look at.
+ * @return Its slot, or the capacity when there is none.
+ */
+size_t vector_hash_next(const vector_hash_t *h, size_t from);
+
+/**
+ * @brief Key stored in a slot returned by vector_hash_next().
+ */
+void *vector_hash_key(const vector_hash_t *h, size_t slot);
+
+/**
+ * @brief Value stored in a slot returned by vector_hash_next().
+ */
+void *vector_hash_value(const vector_hash_t *h, size_t slot);
+
+/**
+ * @brief Iterate over the occupied slots in table order.
+ *
+ * @param _i A size_t variable receiving each slot.
+ * @param h The hash map.
+ *
+ * Example:
+ * @code
+ * size_t i;
+ * vector_hash_foreach(i, h) {
+ *     printf("%d\n", *(int *)vector_hash_value(h, i));
+ * }
+ * @endcode
+ */
+#define vector_hash_foreach(_i, h) \
+    for ((_i) = vector_hash_next((h), 0); (_i) < vector_hash_cap(h); (_i) = vector_hash_next((h), (_i) + 1))
+
+/**
+ * @brief Hash of a 64-bit integer key, a full avalanche mix.
+ *
+ * @param key Pointer to a uint64_t.
+ * @return The hash.
+ */
+size_t vector_hash_u64(const void *key);
+
+#endif /* _VECTOR_HASH_H */
@@ -0,0 +1,125 @@
+#include "vector_heap.h"
+#include "vector_internal.h"
+#include <string.h>
+
+/* Place the element at x into hole i or below, in a heap of n elements. x must lie outside [0, n). */
+static void vector_heap_sift_down(byte_t *v, size_t ts, size_t n, size_t i, const void *x, size_t arity,
+                                  int (*cmp)(const void *, const void *))
+{
+    for (;;)
+    {
+        size_t first = arity * i + 1, best = first, c;
+        if (first >= n)
+            break;
+        size_t end = first + arity < n ? first + arity : n;
+        for (c = first + 1; c < end; c++)
+            if (cmp(v + c * ts, v + best * ts) < 0)
+                best = c;
+        if (cmp(v + best * ts, x) >= 0)
+            break;
+        memcpy(v + i * ts, v + best * ts, ts);
+        i = best;
+    }
+    memcpy(v + i * ts, x, ts);
+}
+
+/* Place the element at x into hole i or above */
+static void vector_heap_sift_up(byte_t *v, size_t ts, size_t i, const void *x, size_t arity,
+                                int (*cmp)(const void *, const void *))
+{
+    while (i > 0 && cmp(x, v + ((i - 1) / arity) * ts) < 0)
+    {
+        memcpy(v + i * ts, v + ((i - 1) / arity) * ts, ts);
+        i = (i - 1) / arity;
+    }
+    memcpy(v + i * ts, x, ts);
+}
+
+vector_status_t vector_heapify(void *vector, size_t arity, int (*cmp)(const void *, const void *))
+{
+    if (!vector || !cmp || arity < 2)
+    {
+        VECTOR_DEBUG_PERROR("Vector Heapify: given null argument or arity below 2.\n");
+        return VEC_ERR;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    size_t n = hdr->len, ts = hdr->tsize, i;
+    if (n < 2)
+        return VEC_OK;
+    if (VECTOR_IS_SHARED(hdr))
+    {
+        VECTOR_DEBUG_PERROR("Vector Heapify: vector is shared, call vector_unique first.\n");
+        return VEC_SHARED;
+    }
+    /* Each sifted element waits in one scratch slot while its hole moves down */
+    byte_t *x = hdr->a->malloc(ts);
+    if (!x)
+    {
+        VECTOR_DEBUG_PERROR("Vector Heapify: allocation failed.\n");
+        return VEC_ERR;
+    }
+    for (i = (n - 2) / arity + 1; i-- > 0;)
+    {
+        memcpy(x, (byte_t *)vector + i * ts, ts);
+        vector_heap_sift_down(vector, ts, n, i, x, arity, cmp);
+    }
+    hdr->a->free(x);
+    return VEC_OK;
+}
+
+vector_status_t vector_heap_pop(void *vector, void *out, size_t arity, int (*cmp)(const void *, const void *))
+{
+    if (!vector || !cmp || arity < 2)
+    {
+        VECTOR_DEBUG_PERROR("Vector Heap Pop: given null argument or arity below 2.\n");
+        return VEC_ERR;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    if (hdr->len == 0)
+        return VEC_EMPTY;
+    if (VECTOR_IS_SHARED(hdr))
+    {
+        VECTOR_DEBUG_PERROR("Vector Heap Pop: vector is shared, call vector_unique first.\n");
+        return VEC_SHARED;
+    }
+    size_t ts = hdr->tsize, n = --hdr->len;
+    if (out)
+        memcpy(out, vector, ts);
+    if (n == 0)
+        return VEC_OK;
+
+    /*
+     * The old last element, now just past the length, almost always belongs
+     * near the bottom: move the hole to a leaf along the smallest children
+     * without comparing against it, then sift it up from there.
+     */
+    byte_t *v = vector;
+    size_t i = 0, first, c;
+    while ((first = arity * i + 1) < n)
+    {
+        size_t best = first, end = first + arity < n ? first + arity : n;
+        for (c = first + 1; c < end; c++)
+            if (cmp(v + c * ts, v + best * ts) < 0)
+                best = c;
+        memcpy(v + i * ts, v + best * ts, ts);
+        i = best;
+    }
+    vector_heap_sift_up(v, ts, i, v + n * ts, arity, cmp);
+    return VEC_OK;
+}
+
+void *internal_vector_heap_push(void *vector, const void *item, size_t arity, int (*cmp)(const void *, const void *))
+{
+    if (!vector || !item || !cmp || arity < 2)
+    {
+        VECTOR_DEBUG_PERROR("Vector Heap Push: given null argument or arity below 2.\n");
+        return NULL;
+    }
+    size_t ts = VECTOR_HEADER(vector)->tsize;
+    vector = internal_vector_prepare_push_back(vector, ts);
+    if (!vector)
+        return NULL;
+    size_t i = VECTOR_HEADER(vector)->len++;
+    vector_heap_sift_up(vector, ts, i, item, arity, cmp);
+    return vector;
+}
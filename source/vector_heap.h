@@ -0,0 +1,173 @@
+#ifndef _VECTOR_HEAP_H
+#define _VECTOR_HEAP_H
+
+#include "vector.h"
+
+/*
+ * Heaps are regular vailed vectors in d-ary heap order: the children of
+ * element i are arity * i + 1 ... arity * i + arity, and no child sorts before
+ * its parent under a qsort-style comparator, so element 0 comes first. Higher
+ * arity makes the tree shallower and keeps the children of a node on one or
+ * two cache lines; 4 is usually fastest.
+ */
+
+/* Arity for callers without a reason to choose another */
+#define VECTOR_HEAP_ARITY 4
+
+#if defined(__GNUC__)
+#define VECTOR_HEAP_FN static __attribute__((unused))
+#else
+#define VECTOR_HEAP_FN static
+#endif
+
+/**
+ * @brief Arrange a vector into heap order. O(n).
+ *
+ * @param vector Vector pointer.
+ * @param arity Children per node, at least 2.
+ * @param cmp qsort-style comparator, the smallest element ends up first.
+ * @return VEC_OK on success, VEC_SHARED if the vector is shared, VEC_ERR on error
+ */
+vector_status_t vector_heapify(void *vector, size_t arity, int (*cmp)(const void *, const void *));
+
+/**
+ * @brief Add a copy of *item to a heap. O(log n).
+ *
+ * Automatically resizes if necessary.
+ *
+ * @param v Vector pointer (may be reassigned).
+ * @param item Pointer to the item to copy in.
+ * @param arity Children per node, the one the heap was built with.
+ * @param cmp qsort-style comparator.
+ */
+#define vector_heap_push(v, item, arity, cmp)                                       \
+    do                                                                              \
+    {                                                                               \
+        void *_tmp = internal_vector_heap_push((v), (item), (arity), (cmp));        \
+        if (_tmp)                                                                   \
+            (v) = _tmp; /* Resize if needed */                                      \
+    } while (0)
+
+/**
+ * @brief Remove the first element of a heap. O(log n).
+ *
+ * @param vector Vector pointer.
+ * @param out Receives the removed element, may be NULL.
+ * @param arity Children per node, the one the heap was built with.
+ * @param cmp qsort-style comparator.
+ * @return VEC_OK on success, VEC_EMPTY if the heap is empty, VEC_SHARED if the vector is shared, VEC_ERR on error
+ */
+vector_status_t vector_heap_pop(void *vector, void *out, size_t arity, int (*cmp)(const void *, const void *));
+
+/**
+ * @brief Generate a typed heap of T with a fixed arity.
+ *
+ * Defines static functions
+ * - vector_heapify_<name>(T *v)
+ * - vector_heap_push_<name>(T **v, T item): may reassign *v, returns VEC_ERR if it cannot grow
+ * - vector_heap_pop_<name>(T *v, T *out): out may be NULL, VEC_EMPTY on an empty heap
+ *
+ * Comparisons are inlined and the arity is a constant, so child indices
+ * compile to shifts for powers of two. Like the typed sorts, heapify and pop
+ * work in place: call vector_unique() first on a vector that may be shared.
+ *
+ * @param name Suffix for the generated functions.
+ * @param T Element type.
+ * @param LESS Function-like macro or function, LESS(a, b) is nonzero when a sorts before b.
+ * @param ARITY Children per node, at least 2.
+ *
+ * Example:
+ * @code
+ * #define INT_LESS(a, b) ((a) < (b))
+ * VECTOR_HEAP_DEFINE(int, int, INT_LESS, 4)
+ * ...
+ * vector_heap_push_int(&v, 42);
+ * vector_heap_pop_int(v, &smallest);
+ * @endcode
+ */
+#define VECTOR_HEAP_DEFINE(name, T, LESS, ARITY)                                          \
+    /* Place x at hole i or below, in a heap of n elements */                             \
+    VECTOR_HEAP_FN void vector_heap_sift_down_##name(T *v, size_t n, size_t i, T x)       \
+    {                                                                                     \
+        for (;;)                                                                          \
+        {                                                                                 \
+            size_t first = (ARITY) * i + 1, best = first, c;                              \
+            if (first >= n)                                                               \
+                break;                                                                    \
+            size_t end = first + (ARITY) < n ? first + (ARITY) : n;                       \
+            for (c = first + 1; c < end; c++)                                             \
+                best = LESS(v[c], v[best]) ? c : best;                                    \
+            if (!LESS(v[best], x))                                                        \
+                break;                                                                    \
+            v[i] = v[best];                                                               \
+            i = best;                                                                     \
+        }                                                                                 \
+        v[i] = x;                                                                         \
+    }                                                                                     \
+                                                                                          \
+    /* Place x at hole i or above */                                                      \
+    VECTOR_HEAP_FN void vector_heap_sift_up_##name(T *v, size_t i, T x)                   \
+    {                                                                                     \
+        while (i > 0 && LESS(x, v[(i - 1) / (ARITY)]))                                    \
+        {                                                                                 \
+            v[i] = v[(i - 1) / (ARITY)];                                                  \
+            i = (i - 1) / (ARITY);                                                        \
+        }                                                                                 \
+        v[i] = x;                                                                         \
+    }                                                                                     \
+                                                                                          \
+    VECTOR_HEAP_FN vector_status_t vector_heapify_##name(T *v)                            \
+    {                                                                                     \
+        size_t n, i;                                                                      \
+        if (vector_get_len(v, &n) != VEC_OK)                                              \
+            return VEC_ERR;                                                               \
+        for (i = n > 1 ? (n - 2) / (ARITY) + 1 : 0; i-- > 0;)                             \
+            vector_heap_sift_down_##name(v, n, i, v[i]);                                  \
+        return VEC_OK;                                                                    \
+    }                                                                                     \
+                                                                                          \
+    VECTOR_HEAP_FN vector_status_t vector_heap_push_##name(T **v, T item)                 \
+    {                                                                                     \
+        size_t i;                                                                         \
+        T *w = v ? internal_vector_prepare_push_back(*v, sizeof(T)) : NULL;               \
+        if (!w)                                                                           \
+            return VEC_ERR;                                                               \
+        *v = w;                                                                           \
+        vector_get_len(w, &i);                                                            \
+        internal_vector_set_len(w, i + 1);                                                \
+        vector_heap_sift_up_##name(w, i, item);                                           \
+        return VEC_OK;                                                                    \
+    }                                                                                     \
+                                                                                          \
+    VECTOR_HEAP_FN vector_status_t vector_heap_pop_##name(T *v, T *out)                   \
+    {                                                                                     \
+        size_t n;                                                                         \
+        if (vector_get_len(v, &n) != VEC_OK)                                              \
+            return VEC_ERR;                                                               \
+        if (n == 0)                                                                       \
+            return VEC_EMPTY;                                                             \
+        if (out)                                                                          \
+            *out = v[0];                                                                  \
+        internal_vector_set_len(v, --n);                                                  \
+        if (n == 0)                                                                       \
+            return VEC_OK;                                                                \
+        /* The last element almost always belongs near the bottom: move the hole to a   \
+         * leaf along the smallest children, then sift it up from there */               \
+        size_t i = 0, first, c;                                                           \
+        while ((first = (ARITY) * i + 1) < n)                                             \
+        {                                                                                 \
+            size_t best = first, end = first + (ARITY) < n ? first + (ARITY) : n;         \
+            for (c = first + 1; c < end; c++)                                             \
+                best = LESS(v[c], v[best]) ? c : best;                                    \
+            v[i] = v[best];                                                               \
+            i = best;                                                                     \
+        }                                                                                 \
+        vector_heap_sift_up_##name(v, i, v[n]);                                           \
+        return VEC_OK;                                                                    \
+    }
+
+/* Internal methdods */
+
+void *internal_vector_heap_push(void *vector, const void *item, size_t arity, int (*cmp)(const void *, const void *));
+
+#endif /* _VECTOR_HEAP_H */
@@ -0,0 +1,42 @@
+#ifndef _VECTOR_INTERNAL_H
+#define _VECTOR_INTERNAL_H
+
+/* Private layout shared by the vector translation units. Not part of the public API. */
+
+#include "vector.h"
+
+#include <stdatomic.h>
+
+typedef struct
+{
+    size_t cap;   /* total capacity */
+    size_t len;   /* current length */
+    size_t tsize; /* type size*/
+    allocator_t *a; /* allocator pointer */
+    atomic_size_t refs; /* owners sharing this buffer, see vector_share() */
+    uint32_t offset;    /* bytes from the allocation to the header, see vector_init_aligned() */
+    uint32_t align;     /* element alignment, 0 for the allocator's default */
+    const vector_type_t *type; /* element lifecycle hooks, NULL for plain bytes */
+    size_t reserved;           /* keeps the header a multiple of 16 bytes */
+} vector_header_t;
+
+typedef unsigned char byte_t;
+
+/* Assumed destructive interference size, used to keep contended fields apart */
+#define VECTOR_CACHE_LINE 64
+
+#define VECTOR_HEADER(vector) ((vector_header_t *)((byte_t *)vector - sizeof(vector_header_t)))
+
+/* More than one owner, in-place changes must not touch the buffer */
+#define VECTOR_IS_SHARED(hdr) (atomic_load_explicit(&(hdr)->refs, memory_order_acquire) > 1)
+
+/* Set every header field for a new, unshared, unaligned and untyped buffer of cap elements */
+void internal_vector_header_init(vector_header_t *hdr, size_t tsize, size_t cap, allocator_t *a);
+
+/* Destroy n elements starting at items, nothing to do for plain bytes */
+void internal_vector_destroy_range(const vector_type_t *type, void *items, size_t n, size_t tsize);
+
+/* Relocate n elements from src to dst, ranges may overlap */
+void internal_vector_move_range(const vector_type_t *type, void *dst, void *src, size_t n, size_t tsize);
+
+#endif /* _VECTOR_INTERNAL_H */
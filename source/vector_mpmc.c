@@ -0,0 +1,162 @@
+#include "vector_mpmc.h"
+#include "vector_internal.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Producers and consumers each contend on their own cache line. */
+typedef struct
+{
+    atomic_size_t enqueue_pos;
+    byte_t pad0[VECTOR_CACHE_LINE - sizeof(atomic_size_t)];
+
+    atomic_size_t dequeue_pos;
+    byte_t pad1[VECTOR_CACHE_LINE - sizeof(atomic_size_t)];
+
+    size_t stride;       /* bytes per slot: sequence number then item */
+    size_t reserved;     /* keeps the slots 16-byte aligned */
+    vector_header_t vec; /* cap (power of two), tsize, allocator; len unused */
+} vector_mpmc_header_t;
+
+#define VECTOR_MPMC_HEADER(queue) ((vector_mpmc_header_t *)((byte_t *)queue - sizeof(vector_mpmc_header_t)))
+
+#define VECTOR_MPMC_SEQ(queue, hdr, pos) \
+    ((atomic_size_t *)((byte_t *)(queue) + ((pos) & ((hdr)->vec.cap - 1)) * (hdr)->stride))
+
+#define VECTOR_MPMC_ITEM(queue, hdr, pos) ((byte_t *)VECTOR_MPMC_SEQ(queue, hdr, pos) + sizeof(atomic_size_t))
+
+/* Initialize a new queue, slot i starts out free for position i */
+void *vector_mpmc_init(size_t tsize, size_t cap, allocator_t *a)
+{
+    if (!a)
+    {
+        VECTOR_DEBUG_PERROR("Vector MPMC Init: given null allocator.\n");
+        return NULL;
+    }
+    size_t slots = 2;
+    while (slots < cap)
+        slots <<= 1;
+    /* items are copied in and out, so only the sequence numbers need alignment */
+    size_t stride = sizeof(atomic_size_t) + (tsize + sizeof(size_t) - 1) / sizeof(size_t) * sizeof(size_t);
+
+    vector_mpmc_header_t *hdr = a->malloc(sizeof(vector_mpmc_header_t) + stride * slots);
+    if (!hdr)
+    {
+        VECTOR_DEBUG_PERROR("Vector MPMC Init: allocation failed.\n");
+        return NULL;
+    }
+    atomic_init(&hdr->enqueue_pos, 0);
+    atomic_init(&hdr->dequeue_pos, 0);
+    hdr->stride = stride;
+    hdr->reserved = 0;
+    internal_vector_header_init(&hdr->vec, tsize, slots, a);
+
+    byte_t *queue = (byte_t *)hdr + sizeof(vector_mpmc_header_t);
+    size_t i;
+    for (i = 0; i < slots; i++)
+        atomic_init(VECTOR_MPMC_SEQ(queue, hdr, i), i);
+    return queue;
+}
+
+/* Free a queue */
+vector_status_t vector_mpmc_free(void *queue)
+{
+    if (!queue)
+    {
+        VECTOR_DEBUG_PERROR("Vector MPMC Free: given null queue.\n");
+        return VEC_ERR;
+    }
+    vector_mpmc_header_t *hdr = VECTOR_MPMC_HEADER(queue);
+    if (!hdr->vec.a)
+    {
+        VECTOR_DEBUG_PERROR("Vector MPMC Free: null allocator in header.\n");
+        return VEC_ERR;
+    }
+    hdr->vec.a->free(hdr);
+    return VEC_OK;
+}
+
+vector_status_t vector_mpmc_push(void *queue, const void *item)
+{
+    return vector_mpmc_push_many(queue, item, 1) == 1 ? VEC_OK : (queue && item ? VEC_FULL : VEC_ERR);
+}
+
+vector_status_t vector_mpmc_pop(void *queue, void *out)
+{
+    return vector_mpmc_pop_many(queue, out, 1) == 1 ? VEC_OK : (queue && out ? VEC_EMPTY : VEC_ERR);
+}
+
+/*
+ * Shared claim loop. A slot is ready for position pos when its sequence equals
+ * pos + lag (lag 0 for producers, 1 for consumers). A run of ready slots stays
+ * ready until the position counter moves past it, so a successful CAS over the
+ * whole run hands all of it to the caller.
+ */
+static size_t vector_mpmc_claim(void *queue, vector_mpmc_header_t *hdr, atomic_size_t *counter, size_t lag, size_t n, size_t *first)
+{
+    if (n == 0)
+        return 0; /* nothing to claim, and the loop below would never exit */
+    size_t pos = atomic_load_explicit(counter, memory_order_relaxed);
+    if (n > hdr->vec.cap)
+        n = hdr->vec.cap;
+    for (;;)
+    {
+        size_t k = 0;
+        intptr_t diff = 0;
+        while (k < n)
+        {
+            size_t seq = atomic_load_explicit(VECTOR_MPMC_SEQ(queue, hdr, pos + k), memory_order_acquire);
+            diff = (intptr_t)(seq - (pos + k + lag));
+            if (diff != 0)
+                break;
+            k++;
+        }
+        if (k == 0 && diff < 0)
+            return 0; /* full (producers) or empty (consumers) */
+        if (k > 0 && atomic_compare_exchange_weak_explicit(counter, &pos, pos + k,
+                                                           memory_order_relaxed, memory_order_relaxed))
+        {
+            *first = pos;
+            return k;
+        }
+        if (k == 0)
+            pos = atomic_load_explicit(counter, memory_order_relaxed); /* another thread got ahead */
+    }
+}
+
+size_t vector_mpmc_push_many(void *queue, const void *items, size_t n)
+{
+    if (!queue || !items)
+    {
+        VECTOR_DEBUG_PERROR("Vector MPMC Push: given null queue or items.\n");
+        return 0;
+    }
+    vector_mpmc_header_t *hdr = VECTOR_MPMC_HEADER(queue);
+    size_t pos, i;
+    size_t k = vector_mpmc_claim(queue, hdr, &hdr->enqueue_pos, 0, n, &pos);
+    for (i = 0; i < k; i++)
+    {
+        memcpy(VECTOR_MPMC_ITEM(queue, hdr, pos + i), (const byte_t *)items + i * hdr->vec.tsize, hdr->vec.tsize);
+        atomic_store_explicit(VECTOR_MPMC_SEQ(queue, hdr, pos + i), pos + i + 1, memory_order_release);
+    }
+    return k;
+}
+
+size_t vector_mpmc_pop_many(void *queue, void *out, size_t n)
+{
+    if (!queue || !out)
+    {
+        VECTOR_DEBUG_PERROR("Vector MPMC Pop: given null queue or out.\n");
+        return 0;
+    }
+    vector_mpmc_header_t *hdr = VECTOR_MPMC_HEADER(queue);
+    size_t pos, i;
+    size_t k = vector_mpmc_claim(queue, hdr, &hdr->dequeue_pos, 1, n, &pos);
+    for (i = 0; i < k; i++)
+    {
+        memcpy((byte_t *)out + i * hdr->vec.tsize, VECTOR_MPMC_ITEM(queue, hdr, pos + i), hdr->vec.tsize);
+        /* free the slot for the producer one lap ahead */
+        atomic_store_explicit(VECTOR_MPMC_SEQ(queue, hdr, pos + i), pos + i + hdr->vec.cap, memory_order_release);
+    }
+    return k;
+}
@@ -0,0 +1,77 @@
+#ifndef _VECTOR_MPMC_H
+#define _VECTOR_MPMC_H
+
+#include "vector.h"
+
+/**
+ * @brief Create a bounded multi-producer/multi-consumer queue of type T.
+ *
+ * Uses the vector allocation layout (header in front of the slot array, all
+ * memory from the given allocator). Every slot carries a sequence number, so
+ * any number of threads may push and pop concurrently without locks. Slots
+ * interleave sequence numbers with items; do not index the returned pointer.
+ *
+ * @param T Type of the elements.
+ * @param cap Minimum capacity, rounded up to a power of two.
+ * @param a Pointer to allocator_t.
+ * @return T* Queue pointer.
+ */
+#define vector_mpmc(T, cap, a) (T *)vector_mpmc_init(sizeof(T), cap, a)
+
+/**
+ * @brief Initialize a MPMC queue.
+ *
+ * @param tsize Size of each element (sizeof(T)).
+ * @param cap Minimum capacity, rounded up to a power of two.
+ * @param a Pointer to allocator_t.
+ * @return void* Queue pointer on success, NULL on failure.
+ */
+void *vector_mpmc_init(size_t tsize, size_t cap, allocator_t *a);
+
+/**
+ * @brief Free a MPMC queue. No thread may be using it.
+ *
+ * @param queue Queue pointer.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_mpmc_free(void *queue);
+
+/**
+ * @brief Copy one item into the queue. Safe from any thread.
+ *
+ * @param queue Queue pointer.
+ * @param item Pointer to the item to copy in.
+ * @return VEC_OK on success, VEC_FULL if no slot is free, VEC_ERR on error
+ */
+vector_status_t vector_mpmc_push(void *queue, const void *item);
+
+/**
+ * @brief Copy one item out of the queue. Safe from any thread.
+ *
+ * @param queue Queue pointer.
+ * @param out Reference to copy the item to.
+ * @return VEC_OK on success, VEC_EMPTY if nothing is queued, VEC_ERR on error
+ */
+vector_status_t vector_mpmc_pop(void *queue, void *out);
+
+/**
+ * @brief Claim up to n consecutive slots with one CAS and copy items into them.
+ *
+ * @param queue Queue pointer.
+ * @param items Source array.
+ * @param n Number of items in source.
+ * @return Number of items actually pushed (0 when full or on error).
+ */
+size_t vector_mpmc_push_many(void *queue, const void *items, size_t n);
+
+/**
+ * @brief Claim up to n consecutive ready slots with one CAS and copy them out.
+ *
+ * @param queue Queue pointer.
+ * @param out Destination array with room for n items.
+ * @param n Maximum number of items to pop.
+ * @return Number of items actually popped (0 when empty or on error).
+ */
+size_t vector_mpmc_pop_many(void *queue, void *out, size_t n);
+
+#endif /* _VECTOR_MPMC_H */
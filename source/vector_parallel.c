@@ -0,0 +1,226 @@
+#include "vector_parallel.h"
+#include "vector_internal.h"
+#include "vector_scheduler.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#define VECTOR_PARALLEL_MIN_GRAIN 1024    /* smallest automatic chunk */
+#define VECTOR_PARALLEL_FIXED_GRAIN 16384 /* automatic chunk for deterministic reductions */
+
+typedef struct vector_parallel_job_t vector_parallel_job_t;
+
+/* Runs one chunk; drainer is the slot of the task running it, 0 for the calling thread */
+typedef void (*vector_chunk_fn_t)(vector_parallel_job_t *job, size_t begin, size_t end, size_t chunk, size_t drainer);
+
+struct vector_parallel_job_t
+{
+    vector_chunk_fn_t run;
+    vector_status_t (*setup)(vector_parallel_job_t *job); /* optional, runs once the drainer count is fixed */
+    size_t len, grain, chunks;
+    size_t workers;       /* drainers taking part, their slots are below it */
+    atomic_size_t next;   /* next chunk to hand out */
+    atomic_size_t joined; /* drainer slots handed out */
+
+    void *in, *out, *ctx;
+    vector_range_fn_t range;
+    vector_map_fn_t map;
+    vector_reduce_fn_t reduce;
+    byte_t *partials; /* one accumulator per chunk or per drainer */
+    size_t slots;
+    const void *identity;
+    allocator_t *a;
+    size_t acc_size;
+    int deterministic;
+};
+
+/* Thread cap from vector_parallel_set_threads(), 0 for every scheduler worker */
+static atomic_size_t requested;
+
+static void vector_parallel_drain(vector_parallel_job_t *job)
+{
+    size_t c, slot = atomic_fetch_add_explicit(&job->joined, 1, memory_order_relaxed);
+    while ((c = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed)) < job->chunks)
+    {
+        size_t begin = c * job->grain;
+        size_t end = job->len - begin < job->grain ? job->len : begin + job->grain;
+        job->run(job, begin, end, c, slot);
+    }
+}
+
+static void vector_parallel_drain_task(void *arg)
+{
+    vector_parallel_drain(arg);
+}
+
+/*
+ * Chunks are handed out from one counter to the caller and to threads - 1
+ * drain tasks on the default scheduler, so the parallel calls share its
+ * workers with vector_parallel_sort() and vector_scheduler_for(). A call made
+ * from inside a chunk spawns onto the worker running it, and waiting there
+ * keeps that worker busy with queued tasks.
+ */
+static vector_status_t vector_parallel_run(vector_parallel_job_t *job)
+{
+    vector_scheduler_t *s = job->chunks > 1 ? vector_scheduler_default() : NULL;
+    size_t helpers = s ? vector_parallel_threads() - 1 : 0, i;
+    if (helpers > job->chunks - 1)
+        helpers = job->chunks - 1;
+    atomic_init(&job->next, 0);
+    atomic_init(&job->joined, 0);
+    job->workers = helpers + 1;
+    if (job->setup && job->setup(job) != VEC_OK)
+        return VEC_ERR;
+
+    vector_task_group_t g;
+    vector_task_group_init(&g);
+    for (i = 0; i < helpers; i++)
+        if (vector_scheduler_spawn(s, &g, vector_parallel_drain_task, job) != VEC_OK)
+            break; /* the caller drains whatever is left */
+    vector_parallel_drain(job);
+    if (s)
+        vector_scheduler_wait(s, &g);
+    return VEC_OK;
+}
+
+/* Fill in the range and chunking of a job, returns the allocator of the vector */
+static allocator_t *vector_parallel_prepare(vector_parallel_job_t *job, void *vector, size_t grain, size_t fixed)
+{
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    memset(job, 0, sizeof(*job));
+    job->in = vector;
+    job->len = hdr->len;
+    if (grain == 0 && fixed)
+        grain = fixed;
+    if (grain == 0)
+    {
+        grain = job->len / (vector_parallel_threads() * 8);
+        if (grain < VECTOR_PARALLEL_MIN_GRAIN)
+            grain = VECTOR_PARALLEL_MIN_GRAIN;
+    }
+    job->grain = grain;
+    job->chunks = (job->len + grain - 1) / grain;
+    return hdr->a;
+}
+
+static void vector_parallel_for_chunk(vector_parallel_job_t *job, size_t begin, size_t end, size_t chunk, size_t drainer)
+{
+    (void)chunk;
+    (void)drainer;
+    job->range(job->in, begin, end, job->ctx);
+}
+
+static void vector_parallel_map_chunk(vector_parallel_job_t *job, size_t begin, size_t end, size_t chunk, size_t drainer)
+{
+    (void)chunk;
+    (void)drainer;
+    job->map(job->in, job->out, begin, end, job->ctx);
+}
+
+static void vector_parallel_reduce_chunk(vector_parallel_job_t *job, size_t begin, size_t end, size_t chunk, size_t drainer)
+{
+    size_t slot = job->deterministic ? chunk : drainer;
+    job->reduce(job->in, begin, end, job->partials + slot * job->acc_size, job->ctx);
+}
+
+/* One partial per chunk, or per drainer of this job */
+static vector_status_t vector_parallel_reduce_setup(vector_parallel_job_t *job)
+{
+    size_t i;
+    job->slots = job->deterministic ? job->chunks : job->workers;
+    job->partials = job->a->malloc(job->slots * job->acc_size + 1);
+    if (!job->partials)
+    {
+        VECTOR_DEBUG_PERROR("Vector Parallel Reduce: allocation failed.\n");
+        return VEC_ERR;
+    }
+    for (i = 0; i < job->slots; i++)
+        memcpy(job->partials + i * job->acc_size, job->identity, job->acc_size);
+    return VEC_OK;
+}
+
+vector_status_t vector_parallel_set_threads(size_t threads)
+{
+    atomic_store_explicit(&requested, threads, memory_order_relaxed);
+    return VEC_OK;
+}
+
+size_t vector_parallel_threads(void)
+{
+    vector_scheduler_t *s = vector_scheduler_default();
+    size_t workers = s ? vector_scheduler_threads(s) : 0;
+    size_t n = atomic_load_explicit(&requested, memory_order_relaxed);
+    if (n == 0)
+        n = workers;
+    /* The caller works too, so one thread more than the workers can run */
+    if (n > workers + 1)
+        n = workers + 1;
+    return n ? n : 1;
+}
+
+vector_status_t vector_parallel_for(void *vector, vector_range_fn_t fn, void *ctx, size_t grain)
+{
+    if (!vector || !fn)
+    {
+        VECTOR_DEBUG_PERROR("Vector Parallel For: given null vector or function.\n");
+        return VEC_ERR;
+    }
+    vector_parallel_job_t job;
+    vector_parallel_prepare(&job, vector, grain, 0);
+    job.run = vector_parallel_for_chunk;
+    job.range = fn;
+    job.ctx = ctx;
+    return vector_parallel_run(&job);
+}
+
+void *vector_parallel_map(void *vector, size_t out_tsize, vector_map_fn_t fn, void *ctx, size_t grain)
+{
+    if (!vector || !fn)
+    {
+        VECTOR_DEBUG_PERROR("Vector Parallel Map: given null vector or function.\n");
+        return NULL;
+    }
+    vector_parallel_job_t job;
+    allocator_t *a = vector_parallel_prepare(&job, vector, grain, 0);
+    job.out = vector_init(out_tsize, job.len, a);
+    if (!job.out)
+    {
+        VECTOR_DEBUG_PERROR("Vector Parallel Map: allocation failed.\n");
+        return NULL;
+    }
+    job.run = vector_parallel_map_chunk;
+    job.map = fn;
+    job.ctx = ctx;
+    vector_parallel_run(&job);
+    internal_vector_set_len(job.out, job.len);
+    return job.out;
+}
+
+vector_status_t vector_parallel_reduce(void *vector, void *acc, size_t acc_size,
+                                       vector_reduce_fn_t reduce, vector_combine_fn_t combine,
+                                       void *ctx, size_t grain, int flags)
+{
+    if (!vector || !acc || !reduce || !combine)
+    {
+        VECTOR_DEBUG_PERROR("Vector Parallel Reduce: given null argument.\n");
+        return VEC_ERR;
+    }
+    vector_parallel_job_t job;
+    int deterministic = (flags & VECTOR_PARALLEL_DETERMINISTIC) != 0;
+    size_t i;
+    job.a = vector_parallel_prepare(&job, vector, grain, deterministic ? VECTOR_PARALLEL_FIXED_GRAIN : 0);
+    job.run = vector_parallel_reduce_chunk;
+    job.setup = vector_parallel_reduce_setup;
+    job.reduce = reduce;
+    job.ctx = ctx;
+    job.identity = acc;
+    job.acc_size = acc_size;
+    job.deterministic = deterministic;
+    if (vector_parallel_run(&job) != VEC_OK)
+        return VEC_ERR;
+
+    /* Chunk order when deterministic, drainer order otherwise */
+    for (i = 0; i < job.slots; i++)
+        combine(acc, job.partials + i * acc_size, ctx);
+    job.a->free(job.partials);
+    return VEC_OK;
+}
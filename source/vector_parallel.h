@@ -0,0 +1,101 @@
+#ifndef _VECTOR_PARALLEL_H
+#define _VECTOR_PARALLEL_H
+
+#include "vector.h"
+
+/**
+ * @brief Combine partial results in chunk order, giving the same answer for
+ * any thread count (also for non-associative operations like float sums).
+ */
+#define VECTOR_PARALLEL_DETERMINISTIC 1
+
+/**
+ * @brief Body of a parallel loop, called once per chunk.
+ *
+ * @param vector The vector being iterated (index it with begin..end).
+ * @param begin First index of the chunk.
+ * @param end One past the last index of the chunk.
+ * @param ctx User context.
+ */
+typedef void (*vector_range_fn_t)(void *vector, size_t begin, size_t end, void *ctx);
+
+/**
+ * @brief Body of a parallel map, writes out[i] for every i in [begin, end).
+ */
+typedef void (*vector_map_fn_t)(const void *in, void *out, size_t begin, size_t end, void *ctx);
+
+/**
+ * @brief Folds in[begin..end) into partial, which starts as a copy of the identity.
+ */
+typedef void (*vector_reduce_fn_t)(const void *in, size_t begin, size_t end, void *partial, void *ctx);
+
+/**
+ * @brief Folds partial into acc.
+ */
+typedef void (*vector_combine_fn_t)(void *acc, const void *partial, void *ctx);
+
+/**
+ * @brief Set the number of threads used by the parallel calls (including the caller).
+ *
+ * The calls run on vector_scheduler_default(), so this caps how many of its
+ * workers one call occupies; it starts no threads. Takes effect from the
+ * next call.
+ *
+ * @param threads Thread count, 0 for every worker of the default scheduler.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_parallel_set_threads(size_t threads);
+
+/**
+ * @brief Number of threads used by the parallel calls, at most the default scheduler's workers plus the caller.
+ */
+size_t vector_parallel_threads(void);
+
+/**
+ * @brief Run fn over the vector's index range split into chunks of grain elements.
+ *
+ * Chunks run on the default work-stealing scheduler (see vector_scheduler.h)
+ * and the calling thread takes part. Calls made from inside a chunk spawn onto
+ * the same workers.
+ *
+ * @param vector Vector pointer.
+ * @param fn Chunk body.
+ * @param ctx User context passed to fn.
+ * @param grain Elements per chunk, 0 picks one from the length and thread count.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_parallel_for(void *vector, vector_range_fn_t fn, void *ctx, size_t grain);
+
+/**
+ * @brief Build a new vector of the same length whose elements are written by fn.
+ *
+ * @param vector Vector pointer.
+ * @param out_tsize Size of each output element.
+ * @param fn Map body.
+ * @param ctx User context passed to fn.
+ * @param grain Elements per chunk, 0 picks one.
+ * @return New vector using the input's allocator, NULL on failure.
+ */
+void *vector_parallel_map(void *vector, size_t out_tsize, vector_map_fn_t fn, void *ctx, size_t grain);
+
+/**
+ * @brief Reduce the vector into acc.
+ *
+ * acc holds the identity on entry and the result on return. Each chunk is
+ * folded into a copy of the identity and the partials are combined into acc.
+ *
+ * @param vector Vector pointer.
+ * @param acc Accumulator, acc_size bytes.
+ * @param acc_size Size of the accumulator.
+ * @param reduce Chunk fold.
+ * @param combine Partial combine.
+ * @param ctx User context passed to both callbacks.
+ * @param grain Elements per chunk, 0 picks one (a fixed one under VECTOR_PARALLEL_DETERMINISTIC).
+ * @param flags 0 or VECTOR_PARALLEL_DETERMINISTIC.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_parallel_reduce(void *vector, void *acc, size_t acc_size,
+                                       vector_reduce_fn_t reduce, vector_combine_fn_t combine,
+                                       void *ctx, size_t grain, int flags);
+
+#endif /* _VECTOR_PARALLEL_H */
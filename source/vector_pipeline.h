@@ -0,0 +1,96 @@
+#ifndef _VECTOR_PIPELINE_H
+#define _VECTOR_PIPELINE_H
+
+#include "vector.h"
+
+/*
+ * Lazy pipelines over a vailed vector. The stages are plain statements in
+ * the body of one loop, so a filter, map, take and reduce chain is a single
+ * pass with every stage inlined and no intermediate vectors; only a collect
+ * stage writes memory.
+ *
+ * A pipeline opens with vector_pipe_begin(), lists its stages in order and
+ * closes with vector_pipe_end. Each element flows through the stages until a
+ * filter drops it or a take stops the pass. Values made by a map stage are
+ * visible to every later stage by name.
+ *
+ * Example:
+ * @code
+ * long sum = 0;
+ * long *squares = vector(long, &a);
+ * vector_pipe_begin(int, x, values)
+ *     vector_pipe_filter(x % 2 == 0)
+ *     vector_pipe_map(long, sq, (long)x * x)
+ *     vector_pipe_take(100)
+ *     vector_pipe_reduce(sum, sum + sq)
+ *     vector_pipe_collect(squares, sq)
+ * vector_pipe_end;
+ * @endcode
+ */
+
+/**
+ * @brief Open a pipeline over the elements of a vector.
+ *
+ * @param T Element type of the vector.
+ * @param x Name each element is bound to for the stages.
+ * @param v Vector pointer (may be NULL, which runs no elements).
+ */
+#define vector_pipe_begin(T, x, v)                                     \
+    do                                                                 \
+    {                                                                  \
+        T *_pipe_src = (v);                                            \
+        size_t _pipe_i, _pipe_len = 0, _pipe_taken = 0;                \
+        if (_pipe_src)                                                 \
+            vector_get_len(_pipe_src, &_pipe_len);                     \
+        (void)_pipe_taken;                                             \
+        for (_pipe_i = 0; _pipe_i < _pipe_len; _pipe_i++)              \
+        {                                                              \
+            T x = _pipe_src[_pipe_i];
+
+/**
+ * @brief Drop elements for which cond is false.
+ */
+#define vector_pipe_filter(cond) \
+    if (!(cond))                 \
+        continue;
+
+/**
+ * @brief Bind the value of expr, of type U, to y for the later stages.
+ */
+#define vector_pipe_map(U, y, expr) U y = (expr);
+
+/**
+ * @brief Let at most n elements reach the later stages, then end the pass.
+ *
+ * At most one take per pipeline.
+ */
+#define vector_pipe_take(n)                                  \
+    if (_pipe_taken == (size_t)(n)) /* take(0) */        \
+        break;                                               \
+    if (++_pipe_taken == (size_t)(n))                        \
+        _pipe_len = _pipe_i + 1; /* no need to look further */
+
+/**
+ * @brief Fold into acc, which must be declared before the pipeline: acc = expr.
+ */
+#define vector_pipe_reduce(acc, expr) (acc) = (expr);
+
+/**
+ * @brief Run any statement per element, e.g. a side effect or an early break.
+ */
+#define vector_pipe_do(stmt) stmt;
+
+/**
+ * @brief Push y onto the vailed vector out (may be reassigned).
+ */
+#define vector_pipe_collect(out, y) vector_push_back(out, y);
+
+/**
+ * @brief Close a pipeline.
+ */
+#define vector_pipe_end \
+    }                   \
+    }                   \
+    while (0)
+
+#endif /* _VECTOR_PIPELINE_H */
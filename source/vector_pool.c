@@ -0,0 +1,237 @@
+#include "vector_pool.h"
+#include "vector_internal.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Written in front of every block handed out, keeps the payload 16-byte aligned */
+typedef struct
+{
+    size_t cls;  /* size class, VECTOR_POOL_DIRECT for plain malloc blocks */
+    size_t size; /* bytes asked for */
+} vector_pool_prefix_t;
+
+#define VECTOR_POOL_DIRECT ((size_t)-1)
+
+#define VECTOR_POOL_BLOCK(cls) ((size_t)1 << ((cls) + VECTOR_POOL_MIN_SHIFT))
+
+/* A free block links to the next one through its first bytes */
+typedef struct vector_pool_block_t
+{
+    struct vector_pool_block_t *next;
+} vector_pool_block_t;
+
+typedef struct
+{
+    vector_pool_block_t *head[VECTOR_POOL_CLASSES];
+    size_t count[VECTOR_POOL_CLASSES];
+    int registered; /* thread exit hook installed */
+} vector_pool_cache_t;
+
+static _Thread_local vector_pool_cache_t cache;
+
+static struct
+{
+    vector_pool_block_t *head[VECTOR_POOL_CLASSES];
+    size_t count[VECTOR_POOL_CLASSES];
+} shared;
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t exit_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t exit_key;
+
+allocator_t vector_pool_allocator = {vector_pool_malloc, vector_pool_realloc, vector_pool_free};
+
+static size_t vector_pool_class(size_t bytes)
+{
+    size_t cls = 0;
+    if (bytes > VECTOR_POOL_BLOCK(VECTOR_POOL_CLASSES - 1))
+        return VECTOR_POOL_DIRECT;
+    while (VECTOR_POOL_BLOCK(cls) < bytes)
+        cls++;
+    return cls;
+}
+
+/* Move blocks of one class from the cache to the shared list until the cache holds keep, freeing any overflow */
+static void vector_pool_release(vector_pool_cache_t *c, size_t cls, size_t keep)
+{
+    vector_pool_block_t *spill = NULL;
+    pthread_mutex_lock(&shared_lock);
+    while (c->count[cls] > keep)
+    {
+        vector_pool_block_t *b = c->head[cls];
+        c->head[cls] = b->next;
+        c->count[cls]--;
+        if (shared.count[cls] < VECTOR_POOL_SHARED_BLOCKS)
+        {
+            b->next = shared.head[cls];
+            shared.head[cls] = b;
+            shared.count[cls]++;
+        }
+        else
+        {
+            b->next = spill;
+            spill = b;
+        }
+    }
+    pthread_mutex_unlock(&shared_lock);
+    while (spill)
+    {
+        vector_pool_block_t *next = spill->next;
+        free(spill);
+        spill = next;
+    }
+}
+
+static void vector_pool_thread_exit(void *arg)
+{
+    vector_pool_cache_t *c = arg;
+    size_t cls;
+    c->registered = 0; /* a later free in another destructor registers again */
+    for (cls = 0; cls < VECTOR_POOL_CLASSES; cls++)
+        vector_pool_release(c, cls, 0);
+}
+
+static void vector_pool_make_key(void)
+{
+    pthread_key_create(&exit_key, vector_pool_thread_exit);
+}
+
+/* Hand the cache over when this thread exits, needed before it first holds a block */
+static void vector_pool_register(vector_pool_cache_t *c)
+{
+    if (c->registered)
+        return;
+    pthread_once(&exit_key_once, vector_pool_make_key);
+    pthread_setspecific(exit_key, c);
+    c->registered = 1;
+}
+
+/* Take up to half a cache worth of blocks from the shared list */
+static void vector_pool_refill(vector_pool_cache_t *c, size_t cls)
+{
+    vector_pool_register(c);
+    pthread_mutex_lock(&shared_lock);
+    while (shared.head[cls] && c->count[cls] < VECTOR_POOL_THREAD_BLOCKS / 2)
+    {
+        vector_pool_block_t *b = shared.head[cls];
+        shared.head[cls] = b->next;
+        shared.count[cls]--;
+        b->next = c->head[cls];
+        c->head[cls] = b;
+        c->count[cls]++;
+    }
+    pthread_mutex_unlock(&shared_lock);
+}
+
+void *vector_pool_malloc(size_t size)
+{
+    size_t cls = vector_pool_class(size + sizeof(vector_pool_prefix_t));
+    vector_pool_prefix_t *p;
+    if (cls == VECTOR_POOL_DIRECT)
+    {
+        p = malloc(size + sizeof(vector_pool_prefix_t));
+    }
+    else
+    {
+        vector_pool_cache_t *c = &cache;
+        if (!c->head[cls])
+            vector_pool_refill(c, cls);
+        if (c->head[cls])
+        {
+            vector_pool_block_t *b = c->head[cls];
+            c->head[cls] = b->next;
+            c->count[cls]--;
+            p = (vector_pool_prefix_t *)b;
+        }
+        else
+        {
+            p = malloc(VECTOR_POOL_BLOCK(cls));
+        }
+    }
+    if (!p)
+    {
+        VECTOR_DEBUG_PERROR("Vector Pool Malloc: allocation failed.\n");
+        return NULL;
+    }
+    p->cls = cls;
+    p->size = size;
+    return p + 1;
+}
+
+void vector_pool_free(void *ptr)
+{
+    if (!ptr)
+        return;
+    vector_pool_prefix_t *p = (vector_pool_prefix_t *)ptr - 1;
+    size_t cls = p->cls;
+    if (cls == VECTOR_POOL_DIRECT)
+    {
+        free(p);
+        return;
+    }
+    vector_pool_cache_t *c = &cache;
+    vector_pool_register(c);
+    vector_pool_block_t *b = (vector_pool_block_t *)p;
+    b->next = c->head[cls];
+    c->head[cls] = b;
+    if (++c->count[cls] > VECTOR_POOL_THREAD_BLOCKS)
+        vector_pool_release(c, cls, VECTOR_POOL_THREAD_BLOCKS / 2);
+}
+
+void *vector_pool_realloc(void *ptr, size_t size)
+{
+    if (!ptr)
+        return vector_pool_malloc(size);
+    vector_pool_prefix_t *p = (vector_pool_prefix_t *)ptr - 1;
+    size_t cls = vector_pool_class(size + sizeof(vector_pool_prefix_t));
+    if (cls == p->cls && cls != VECTOR_POOL_DIRECT)
+    {
+        p->size = size;
+        return ptr;
+    }
+    if (cls == VECTOR_POOL_DIRECT && p->cls == VECTOR_POOL_DIRECT)
+    {
+        p = realloc(p, size + sizeof(vector_pool_prefix_t));
+        if (!p)
+        {
+            VECTOR_DEBUG_PERROR("Vector Pool Realloc: realloc failed.\n");
+            return NULL;
+        }
+        p->size = size;
+        return p + 1;
+    }
+    void *moved = vector_pool_malloc(size);
+    if (!moved)
+        return NULL;
+    memcpy(moved, ptr, p->size < size ? p->size : size);
+    vector_pool_free(ptr);
+    return moved;
+}
+
+vector_status_t vector_pool_trim(void)
+{
+    vector_pool_block_t *spill = NULL;
+    size_t cls;
+    vector_pool_thread_exit(&cache);
+    pthread_mutex_lock(&shared_lock);
+    for (cls = 0; cls < VECTOR_POOL_CLASSES; cls++)
+    {
+        while (shared.head[cls])
+        {
+            vector_pool_block_t *b = shared.head[cls];
+            shared.head[cls] = b->next;
+            b->next = spill;
+            spill = b;
+        }
+        shared.count[cls] = 0;
+    }
+    pthread_mutex_unlock(&shared_lock);
+    while (spill)
+    {
+        vector_pool_block_t *next = spill->next;
+        free(spill);
+        spill = next;
+    }
+    return VEC_OK;
+}
@@ -0,0 +1,62 @@
+#ifndef _VECTOR_POOL_H
+#define _VECTOR_POOL_H
+
+#include "vector.h"
+
+/* Smallest block, 2^VECTOR_POOL_MIN_SHIFT bytes including the block prefix */
+#define VECTOR_POOL_MIN_SHIFT 6
+/* Power of two size classes, blocks above the largest go straight to malloc */
+#define VECTOR_POOL_CLASSES 15
+/* Free blocks a thread keeps per class before handing half to the shared list */
+#define VECTOR_POOL_THREAD_BLOCKS 32
+/* Free blocks the shared list keeps per class, the rest go back to free() */
+#define VECTOR_POOL_SHARED_BLOCKS 256
+
+/**
+ * @brief Allocator that recycles freed blocks by size class.
+ *
+ * Pass &vector_pool_allocator wherever an allocator_t is taken. Requests are
+ * rounded up to a power of two (64 bytes up to 1 MiB) and freed blocks are
+ * kept for reuse instead of going back to free(): first in a lock-free
+ * per-thread cache, then in a bounded shared list behind a mutex. realloc
+ * within the same class returns the same block, so a growing vector only
+ * moves when it crosses a power of two. A thread's cache is handed to the
+ * shared list when the thread exits.
+ *
+ * Blocks may be freed by any thread. Memory from the system allocator and
+ * from this one must not be mixed.
+ */
+extern allocator_t vector_pool_allocator;
+
+/**
+ * @brief Allocate a block of at least size bytes.
+ *
+ * @param size Bytes wanted.
+ * @return Pointer to the block, NULL on failure.
+ */
+void *vector_pool_malloc(size_t size);
+
+/**
+ * @brief Resize a block, in place when the size class does not change.
+ *
+ * @param ptr Block from this allocator, or NULL to allocate.
+ * @param size Bytes wanted.
+ * @return Pointer to the block, NULL on failure (ptr stays valid).
+ */
+void *vector_pool_realloc(void *ptr, size_t size);
+
+/**
+ * @brief Return a block to the pool.
+ *
+ * @param ptr Block from this allocator, or NULL.
+ */
+void vector_pool_free(void *ptr);
+
+/**
+ * @brief Give the calling thread's cached blocks and the shared list back to free().
+ *
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_pool_trim(void);
+
+#endif /* _VECTOR_POOL_H */
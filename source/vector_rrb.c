@@ -0,0 +1,634 @@
+#include "vector_rrb.h"
+#include "vector_internal.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#define VECTOR_RRB_EXTRAS 2    /* nodes a rebalanced level may exceed the optimum by */
+#define VECTOR_RRB_INVARIANT 1 /* nodes with fewer free slots are left alone */
+
+/*
+ * A tree of height h has leaves at depth h; a height 0 tree is a single leaf.
+ * Leaves hold up to VECTOR_RRB_WIDTH elements right after the node header.
+ * Branches always carry cumulative child sizes. In a fully dense branch child i
+ * starts at i << (VECTOR_RRB_BITS * h), and relaxed children are only ever
+ * smaller, so lookups start at that radix guess and scan forward.
+ */
+typedef struct
+{
+    atomic_size_t refs;
+    size_t count; /* elements in a leaf, children in a branch */
+} vector_rrb_node_t;
+
+typedef struct
+{
+    vector_rrb_node_t node;
+    size_t sizes[VECTOR_RRB_WIDTH];
+    vector_rrb_node_t *child[VECTOR_RRB_WIDTH];
+} vector_rrb_branch_t;
+
+struct vector_rrb_t
+{
+    size_t len;
+    size_t height;
+    size_t tsize;
+    allocator_t *a;
+    vector_rrb_node_t *root; /* NULL when empty */
+};
+
+#define VECTOR_RRB_LEAF_DATA(n) ((byte_t *)(n) + sizeof(vector_rrb_node_t))
+#define VECTOR_RRB_BRANCH(n) ((vector_rrb_branch_t *)(n))
+
+/* -------- Nodes -------- */
+
+static vector_rrb_node_t *vector_rrb_leaf_new(const vector_rrb_t *r, size_t count)
+{
+    vector_rrb_node_t *n = r->a->malloc(sizeof(vector_rrb_node_t) + VECTOR_RRB_WIDTH * r->tsize);
+    if (!n)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB: leaf allocation failed.\n");
+        return NULL;
+    }
+    atomic_init(&n->refs, 1);
+    n->count = count;
+    return n;
+}
+
+static vector_rrb_branch_t *vector_rrb_branch_new(const vector_rrb_t *r)
+{
+    vector_rrb_branch_t *b = r->a->malloc(sizeof(vector_rrb_branch_t));
+    if (!b)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB: branch allocation failed.\n");
+        return NULL;
+    }
+    atomic_init(&b->node.refs, 1);
+    b->node.count = 0;
+    return b;
+}
+
+static vector_rrb_node_t *vector_rrb_retain(vector_rrb_node_t *n)
+{
+    atomic_fetch_add_explicit(&n->refs, 1, memory_order_relaxed);
+    return n;
+}
+
+static void vector_rrb_release(const vector_rrb_t *r, vector_rrb_node_t *n, size_t height)
+{
+    if (!n || atomic_fetch_sub_explicit(&n->refs, 1, memory_order_acq_rel) > 1)
+        return;
+    if (height > 0)
+    {
+        size_t i;
+        for (i = 0; i < n->count; i++)
+            vector_rrb_release(r, VECTOR_RRB_BRANCH(n)->child[i], height - 1);
+    }
+    r->a->free(n);
+}
+
+/* Number of elements below a node */
+static size_t vector_rrb_size(const vector_rrb_node_t *n, size_t height)
+{
+    return height == 0 ? n->count : VECTOR_RRB_BRANCH(n)->sizes[n->count - 1];
+}
+
+/* Recompute the cumulative sizes of a branch at height from its children */
+static void vector_rrb_branch_sizes(vector_rrb_branch_t *b, size_t height)
+{
+    size_t i, total = 0;
+    for (i = 0; i < b->node.count; i++)
+    {
+        total += vector_rrb_size(b->child[i], height - 1);
+        b->sizes[i] = total;
+    }
+}
+
+/* Child of a branch at height holding index, which is made relative to that child */
+static size_t vector_rrb_slot(const vector_rrb_branch_t *b, size_t height, size_t *index)
+{
+    size_t slot = *index >> (VECTOR_RRB_BITS * height);
+    while (b->sizes[slot] <= *index)
+        slot++;
+    if (slot > 0)
+        *index -= b->sizes[slot - 1];
+    return slot;
+}
+
+/* Version struct sharing r's settings */
+static vector_rrb_t *vector_rrb_version(const vector_rrb_t *r, vector_rrb_node_t *root, size_t height)
+{
+    vector_rrb_t *v = r->a->malloc(sizeof(vector_rrb_t));
+    if (!v)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB: allocation failed.\n");
+        vector_rrb_release(r, root, height);
+        return NULL;
+    }
+    v->tsize = r->tsize;
+    v->a = r->a;
+    v->root = root;
+    v->height = height;
+    v->len = root ? vector_rrb_size(root, height) : 0;
+
+    /* Drop single-child roots left behind by slicing and concatenation */
+    while (v->root && v->height > 0 && v->root->count == 1)
+    {
+        vector_rrb_node_t *child = vector_rrb_retain(VECTOR_RRB_BRANCH(v->root)->child[0]);
+        vector_rrb_release(v, v->root, v->height);
+        v->root = child;
+        v->height--;
+    }
+    return v;
+}
+
+/* -------- Path copying -------- */
+
+static vector_rrb_node_t *vector_rrb_set_node(const vector_rrb_t *r, vector_rrb_node_t *n, size_t height,
+                                              size_t index, const void *item)
+{
+    if (height == 0)
+    {
+        vector_rrb_node_t *leaf = vector_rrb_leaf_new(r, n->count);
+        if (!leaf)
+            return NULL;
+        memcpy(VECTOR_RRB_LEAF_DATA(leaf), VECTOR_RRB_LEAF_DATA(n), n->count * r->tsize);
+        memcpy(VECTOR_RRB_LEAF_DATA(leaf) + index * r->tsize, item, r->tsize);
+        return leaf;
+    }
+    vector_rrb_branch_t *src = VECTOR_RRB_BRANCH(n);
+    size_t slot = vector_rrb_slot(src, height, &index);
+    vector_rrb_node_t *child = vector_rrb_set_node(r, src->child[slot], height - 1, index, item);
+    if (!child)
+        return NULL;
+    vector_rrb_branch_t *b = vector_rrb_branch_new(r);
+    if (!b)
+    {
+        vector_rrb_release(r, child, height - 1);
+        return NULL;
+    }
+    *b = *src;
+    atomic_init(&b->node.refs, 1);
+    size_t i;
+    for (i = 0; i < b->node.count; i++)
+        if (i != slot)
+            vector_rrb_retain(b->child[i]);
+    b->child[slot] = child;
+    return &b->node;
+}
+
+/* First n elements of a node, 0 < n <= size */
+static vector_rrb_node_t *vector_rrb_take(const vector_rrb_t *r, vector_rrb_node_t *n, size_t height, size_t count)
+{
+    if (count == vector_rrb_size(n, height))
+        return vector_rrb_retain(n);
+    if (height == 0)
+    {
+        vector_rrb_node_t *leaf = vector_rrb_leaf_new(r, count);
+        if (leaf)
+            memcpy(VECTOR_RRB_LEAF_DATA(leaf), VECTOR_RRB_LEAF_DATA(n), count * r->tsize);
+        return leaf;
+    }
+    vector_rrb_branch_t *src = VECTOR_RRB_BRANCH(n);
+    size_t last = count - 1;
+    size_t slot = vector_rrb_slot(src, height, &last);
+    vector_rrb_node_t *child = vector_rrb_take(r, src->child[slot], height - 1, last + 1);
+    if (!child)
+        return NULL;
+    vector_rrb_branch_t *b = vector_rrb_branch_new(r);
+    if (!b)
+    {
+        vector_rrb_release(r, child, height - 1);
+        return NULL;
+    }
+    size_t i;
+    for (i = 0; i < slot; i++)
+        b->child[i] = vector_rrb_retain(src->child[i]);
+    b->child[slot] = child;
+    b->node.count = slot + 1;
+    vector_rrb_branch_sizes(b, height);
+    return &b->node;
+}
+
+/* Everything after the first k elements of a node, k < size */
+static vector_rrb_node_t *vector_rrb_drop(const vector_rrb_t *r, vector_rrb_node_t *n, size_t height, size_t k)
+{
+    if (k == 0)
+        return vector_rrb_retain(n);
+    if (height == 0)
+    {
+        vector_rrb_node_t *leaf = vector_rrb_leaf_new(r, n->count - k);
+        if (leaf)
+            memcpy(VECTOR_RRB_LEAF_DATA(leaf), VECTOR_RRB_LEAF_DATA(n) + k * r->tsize, (n->count - k) * r->tsize);
+        return leaf;
+    }
+    vector_rrb_branch_t *src = VECTOR_RRB_BRANCH(n);
+    size_t slot = vector_rrb_slot(src, height, &k);
+    vector_rrb_node_t *child = vector_rrb_drop(r, src->child[slot], height - 1, k);
+    if (!child)
+        return NULL;
+    vector_rrb_branch_t *b = vector_rrb_branch_new(r);
+    if (!b)
+    {
+        vector_rrb_release(r, child, height - 1);
+        return NULL;
+    }
+    size_t i;
+    b->child[0] = child;
+    for (i = slot + 1; i < src->node.count; i++)
+        b->child[i - slot] = vector_rrb_retain(src->child[i]);
+    b->node.count = src->node.count - slot;
+    vector_rrb_branch_sizes(b, height);
+    return &b->node;
+}
+
+/* -------- Concatenation -------- */
+
+/*
+ * Redistribute the children of left (minus its last), center and right (minus
+ * its first), all branches at height, so that at most VECTOR_RRB_EXTRAS more
+ * nodes than optimal remain. Returns a branch at height + 1 holding the one or
+ * two resulting branches. Inputs are borrowed.
+ */
+static vector_rrb_node_t *vector_rrb_rebalance(const vector_rrb_t *r, vector_rrb_branch_t *left,
+                                               vector_rrb_branch_t *center, vector_rrb_branch_t *right,
+                                               size_t height)
+{
+    vector_rrb_node_t *all[3 * VECTOR_RRB_WIDTH];
+    vector_rrb_node_t *out[3 * VECTOR_RRB_WIDTH];
+    size_t plan[3 * VECTOR_RRB_WIDTH];
+    size_t n = 0, i, j;
+
+    if (left)
+        for (i = 0; i + 1 < left->node.count; i++)
+            all[n++] = left->child[i];
+    for (i = 0; i < center->node.count; i++)
+        all[n++] = center->child[i];
+    if (right)
+        for (i = 1; i < right->node.count; i++)
+            all[n++] = right->child[i];
+
+    /* Plan the slot counts of the new children */
+    size_t total = 0, count = n;
+    for (i = 0; i < n; i++)
+    {
+        plan[i] = all[i]->count;
+        total += plan[i];
+    }
+    size_t optimal = (total + VECTOR_RRB_WIDTH - 1) / VECTOR_RRB_WIDTH;
+    i = 0;
+    while (optimal + VECTOR_RRB_EXTRAS < count)
+    {
+        while (plan[i] > VECTOR_RRB_WIDTH - VECTOR_RRB_INVARIANT)
+            i++;
+        /* Spread this short node over its successors */
+        size_t remaining = plan[i];
+        do
+        {
+            size_t fill = remaining + plan[i + 1];
+            if (fill > VECTOR_RRB_WIDTH)
+                fill = VECTOR_RRB_WIDTH;
+            remaining = remaining + plan[i + 1] - fill;
+            plan[i] = fill;
+            i++;
+        } while (remaining > 0);
+        for (j = i; j + 1 < count; j++)
+            plan[j] = plan[j + 1];
+        count--;
+        i--;
+    }
+
+    /* Build the planned children, reusing untouched ones */
+    size_t src = 0, offset = 0, built = 0, handed = 0;
+    for (j = 0; j < count; j++)
+    {
+        if (offset == 0 && all[src]->count == plan[j])
+        {
+            out[built++] = vector_rrb_retain(all[src++]);
+            continue;
+        }
+        vector_rrb_node_t *node;
+        vector_rrb_branch_t *b = NULL;
+        if (height == 1)
+            node = vector_rrb_leaf_new(r, 0);
+        else
+            node = (vector_rrb_node_t *)(b = vector_rrb_branch_new(r));
+        if (!node)
+            goto fail;
+        while (node->count < plan[j])
+        {
+            size_t take = all[src]->count - offset;
+            if (take > plan[j] - node->count)
+                take = plan[j] - node->count;
+            if (height == 1)
+                memcpy(VECTOR_RRB_LEAF_DATA(node) + node->count * r->tsize,
+                       VECTOR_RRB_LEAF_DATA(all[src]) + offset * r->tsize, take * r->tsize);
+            else
+                for (i = 0; i < take; i++)
+                    b->child[node->count + i] = vector_rrb_retain(VECTOR_RRB_BRANCH(all[src])->child[offset + i]);
+            node->count += take;
+            offset += take;
+            if (offset == all[src]->count)
+            {
+                src++;
+                offset = 0;
+            }
+        }
+        if (b)
+            vector_rrb_branch_sizes(b, height - 1);
+        out[built++] = node;
+    }
+
+    /* Pack into at most two branches at height under a new parent */
+    vector_rrb_branch_t *parent = vector_rrb_branch_new(r);
+    if (!parent)
+        goto fail;
+    for (i = 0; i < count; i += VECTOR_RRB_WIDTH)
+    {
+        vector_rrb_branch_t *b = vector_rrb_branch_new(r);
+        if (!b)
+        {
+            vector_rrb_release(r, &parent->node, height + 1);
+            goto fail;
+        }
+        size_t end = count - i < VECTOR_RRB_WIDTH ? count : i + VECTOR_RRB_WIDTH;
+        for (j = i; j < end; j++)
+            b->child[j - i] = out[j];
+        b->node.count = end - i;
+        handed = end;
+        vector_rrb_branch_sizes(b, height);
+        parent->child[parent->node.count++] = &b->node;
+    }
+    vector_rrb_branch_sizes(parent, height + 1);
+    return &parent->node;
+
+fail:
+    /* Children already handed to branches are released with them */
+    for (j = handed; j < built; j++)
+        vector_rrb_release(r, out[j], height - 1);
+    return NULL;
+}
+
+/* Concatenate two nodes, returning a branch at max(lh, rh) + 1 with one or two children */
+static vector_rrb_node_t *vector_rrb_concat_node(const vector_rrb_t *r, vector_rrb_node_t *left, size_t lh,
+                                                 vector_rrb_node_t *right, size_t rh)
+{
+    vector_rrb_branch_t *lb = VECTOR_RRB_BRANCH(left), *rb = VECTOR_RRB_BRANCH(right);
+    vector_rrb_node_t *center;
+    size_t height = lh > rh ? lh : rh;
+
+    if (lh > rh)
+        center = vector_rrb_concat_node(r, lb->child[left->count - 1], lh - 1, right, rh);
+    else if (lh < rh)
+        center = vector_rrb_concat_node(r, left, lh, rb->child[0], rh - 1);
+    else if (lh > 0)
+        center = vector_rrb_concat_node(r, lb->child[left->count - 1], lh - 1, rb->child[0], rh - 1);
+    else
+    {
+        /* Two leaves: merge when they fit, the parent rebalances otherwise */
+        vector_rrb_branch_t *b = vector_rrb_branch_new(r);
+        if (!b)
+            return NULL;
+        if (left->count + right->count <= VECTOR_RRB_WIDTH)
+        {
+            vector_rrb_node_t *leaf = vector_rrb_leaf_new(r, left->count + right->count);
+            if (!leaf)
+            {
+                r->a->free(b);
+                return NULL;
+            }
+            memcpy(VECTOR_RRB_LEAF_DATA(leaf), VECTOR_RRB_LEAF_DATA(left), left->count * r->tsize);
+            memcpy(VECTOR_RRB_LEAF_DATA(leaf) + left->count * r->tsize, VECTOR_RRB_LEAF_DATA(right),
+                   right->count * r->tsize);
+            b->child[b->node.count++] = leaf;
+        }
+        else
+        {
+            b->child[b->node.count++] = vector_rrb_retain(left);
+            b->child[b->node.count++] = vector_rrb_retain(right);
+        }
+        vector_rrb_branch_sizes(b, 1);
+        return &b->node;
+    }
+    if (!center)
+        return NULL;
+
+    vector_rrb_node_t *ret = vector_rrb_rebalance(r, lh >= rh ? lb : NULL, VECTOR_RRB_BRANCH(center),
+                                                  rh >= lh ? rb : NULL, height);
+    vector_rrb_release(r, center, height);
+    return ret;
+}
+
+/* -------- Public API -------- */
+
+vector_rrb_t *vector_rrb_init(size_t tsize, allocator_t *a)
+{
+    if (!a)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB Init: given null allocator.\n");
+        return NULL;
+    }
+    vector_rrb_t r = {0, 0, tsize, a, NULL};
+    return vector_rrb_version(&r, NULL, 0);
+}
+
+vector_rrb_t *vector_rrb_from_vector(void *vector)
+{
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB From Vector: given null vector.\n");
+        return NULL;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    vector_rrb_t r = {0, 0, hdr->tsize, hdr->a, NULL};
+    if (hdr->len == 0)
+        return vector_rrb_version(&r, NULL, 0);
+
+    /* One level at a time, packing every level densely */
+    size_t count = (hdr->len + VECTOR_RRB_WIDTH - 1) / VECTOR_RRB_WIDTH;
+    vector_rrb_node_t **level = hdr->a->malloc(count * sizeof(vector_rrb_node_t *));
+    if (!level)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB From Vector: allocation failed.\n");
+        return NULL;
+    }
+    size_t i, j, height = 0;
+    for (i = 0; i < count; i++)
+    {
+        size_t begin = i * VECTOR_RRB_WIDTH;
+        size_t n = hdr->len - begin < VECTOR_RRB_WIDTH ? hdr->len - begin : VECTOR_RRB_WIDTH;
+        level[i] = vector_rrb_leaf_new(&r, n);
+        if (!level[i])
+            goto fail;
+        memcpy(VECTOR_RRB_LEAF_DATA(level[i]), (byte_t *)vector + begin * hdr->tsize, n * hdr->tsize);
+    }
+    while (count > 1)
+    {
+        size_t parents = (count + VECTOR_RRB_WIDTH - 1) / VECTOR_RRB_WIDTH;
+        height++;
+        for (i = 0; i < parents; i++)
+        {
+            vector_rrb_branch_t *b = vector_rrb_branch_new(&r);
+            if (!b)
+            {
+                /* Release the parents built so far and the children not yet adopted */
+                for (j = 0; j < i; j++)
+                    vector_rrb_release(&r, level[j], height);
+                for (j = i * VECTOR_RRB_WIDTH; j < count; j++)
+                    vector_rrb_release(&r, level[j], height - 1);
+                hdr->a->free(level);
+                return NULL;
+            }
+            for (j = i * VECTOR_RRB_WIDTH; j < count && j < (i + 1) * VECTOR_RRB_WIDTH; j++)
+                b->child[b->node.count++] = level[j];
+            vector_rrb_branch_sizes(b, height);
+            level[i] = &b->node;
+        }
+        count = parents;
+    }
+    vector_rrb_node_t *root = level[0];
+    hdr->a->free(level);
+    return vector_rrb_version(&r, root, height);
+
+fail:
+    for (j = 0; j < i; j++)
+        vector_rrb_release(&r, level[j], 0);
+    hdr->a->free(level);
+    return NULL;
+}
+
+/* Copy the elements below a node to out, returns the position after them */
+static byte_t *vector_rrb_flatten(const vector_rrb_t *r, const vector_rrb_node_t *n, size_t height, byte_t *out)
+{
+    if (height == 0)
+    {
+        memcpy(out, VECTOR_RRB_LEAF_DATA(n), n->count * r->tsize);
+        return out + n->count * r->tsize;
+    }
+    size_t i;
+    for (i = 0; i < n->count; i++)
+        out = vector_rrb_flatten(r, VECTOR_RRB_BRANCH(n)->child[i], height - 1, out);
+    return out;
+}
+
+void *vector_rrb_to_vector(const vector_rrb_t *r)
+{
+    if (!r)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB To Vector: given null version.\n");
+        return NULL;
+    }
+    void *vector = vector_init(r->tsize, r->len, r->a);
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB To Vector: allocation failed.\n");
+        return NULL;
+    }
+    if (r->root)
+        vector_rrb_flatten(r, r->root, r->height, vector);
+    internal_vector_set_len(vector, r->len);
+    return vector;
+}
+
+vector_status_t vector_rrb_free(vector_rrb_t *r)
+{
+    if (!r)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB Free: given null version.\n");
+        return VEC_ERR;
+    }
+    vector_rrb_release(r, r->root, r->height);
+    r->a->free(r);
+    return VEC_OK;
+}
+
+size_t vector_rrb_len(const vector_rrb_t *r)
+{
+    if (!r)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB Len: given null version.\n");
+        return 0;
+    }
+    return r->len;
+}
+
+const void *vector_rrb_at(const vector_rrb_t *r, size_t index)
+{
+    if (!r || index >= r->len)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB At: given null version or index out of bounds.\n");
+        return NULL;
+    }
+    const vector_rrb_node_t *n = r->root;
+    size_t height;
+    for (height = r->height; height > 0; height--)
+        n = VECTOR_RRB_BRANCH(n)->child[vector_rrb_slot(VECTOR_RRB_BRANCH(n), height, &index)];
+    return VECTOR_RRB_LEAF_DATA(n) + index * r->tsize;
+}
+
+vector_rrb_t *vector_rrb_set(const vector_rrb_t *r, size_t index, const void *item)
+{
+    if (!r || !item || index >= r->len)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB Set: given null argument or index out of bounds.\n");
+        return NULL;
+    }
+    vector_rrb_node_t *root = vector_rrb_set_node(r, r->root, r->height, index, item);
+    if (!root)
+        return NULL;
+    return vector_rrb_version(r, root, r->height);
+}
+
+vector_rrb_t *vector_rrb_push(const vector_rrb_t *r, const void *item)
+{
+    if (!r || !item)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB Push: given null argument.\n");
+        return NULL;
+    }
+    /* Concatenate a one element leaf, which only copies the right spine */
+    vector_rrb_node_t *leaf = vector_rrb_leaf_new(r, 1);
+    if (!leaf)
+        return NULL;
+    memcpy(VECTOR_RRB_LEAF_DATA(leaf), item, r->tsize);
+    vector_rrb_t single = {1, 0, r->tsize, r->a, leaf};
+    vector_rrb_t *ret = vector_rrb_concat(r, &single);
+    vector_rrb_release(r, leaf, 0);
+    return ret;
+}
+
+vector_rrb_t *vector_rrb_slice(const vector_rrb_t *r, size_t begin, size_t end)
+{
+    if (!r || begin > end || end > r->len)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB Slice: given null version or range out of bounds.\n");
+        return NULL;
+    }
+    if (begin == end)
+        return vector_rrb_version(r, NULL, 0);
+    vector_rrb_node_t *head = vector_rrb_take(r, r->root, r->height, end);
+    if (!head)
+        return NULL;
+    vector_rrb_node_t *root = vector_rrb_drop(r, head, r->height, begin);
+    vector_rrb_release(r, head, r->height);
+    if (!root)
+        return NULL;
+    return vector_rrb_version(r, root, r->height);
+}
+
+vector_rrb_t *vector_rrb_concat(const vector_rrb_t *x, const vector_rrb_t *y)
+{
+    if (!x || !y || x->tsize != y->tsize)
+    {
+        VECTOR_DEBUG_PERROR("Vector RRB Concat: given null or mismatched versions.\n");
+        return NULL;
+    }
+    if (!x->root || !y->root)
+    {
+        const vector_rrb_t *src = x->root ? x : y;
+        return vector_rrb_version(x, src->root ? vector_rrb_retain(src->root) : NULL, src->height);
+    }
+    size_t height = x->height > y->height ? x->height : y->height;
+    vector_rrb_node_t *root = vector_rrb_concat_node(x, x->root, x->height, y->root, y->height);
+    if (!root)
+        return NULL;
+    return vector_rrb_version(x, root, height + 1);
+}
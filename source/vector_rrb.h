@@ -0,0 +1,127 @@
+#ifndef _VECTOR_RRB_H
+#define _VECTOR_RRB_H
+
+#include "vector.h"
+
+/* Children per tree node and elements per leaf */
+#define VECTOR_RRB_BITS 5
+#define VECTOR_RRB_WIDTH (1 << VECTOR_RRB_BITS)
+
+/**
+ * @brief Persistent vector (relaxed radix balanced tree).
+ *
+ * Every version is immutable. Operations that change the contents return a new
+ * version that shares all untouched nodes with the old one, so old versions
+ * stay valid and cost only the nodes on the changed paths. Nodes are reference
+ * counted atomically, so versions may be read and freed from any thread.
+ *
+ * Each version is freed with vector_rrb_free() independently of the others.
+ */
+typedef struct vector_rrb_t vector_rrb_t;
+
+/**
+ * @brief Create an empty persistent vector for elements of type T.
+ *
+ * @param T Type of the elements.
+ * @param a Pointer to allocator_t.
+ * @return vector_rrb_t* on success, NULL on failure.
+ */
+#define vector_rrb(T, a) vector_rrb_init(sizeof(T), a)
+
+/**
+ * @brief Read the element at index as type T. No bounds check.
+ */
+#define vector_rrb_get(T, r, index) (*(const T *)vector_rrb_at((r), (index)))
+
+/**
+ * @brief Create an empty persistent vector.
+ *
+ * @param tsize Size of each element (sizeof(T)).
+ * @param a Pointer to allocator_t, used for every node and version.
+ * @return vector_rrb_t* on success, NULL on failure.
+ */
+vector_rrb_t *vector_rrb_init(size_t tsize, allocator_t *a);
+
+/**
+ * @brief Build a persistent vector holding a copy of a vailed vector. O(n).
+ *
+ * @param vector Vector pointer, its allocator is used for the tree.
+ * @return vector_rrb_t* on success, NULL on failure.
+ */
+vector_rrb_t *vector_rrb_from_vector(void *vector);
+
+/**
+ * @brief Copy a version into a new vailed vector with capacity equal to its length. O(n).
+ *
+ * @param r Version.
+ * @return Pointer to the new vector on success, NULL on failure.
+ */
+void *vector_rrb_to_vector(const vector_rrb_t *r);
+
+/**
+ * @brief Free a version. Nodes still shared with other versions stay alive.
+ *
+ * @param r Version.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_rrb_free(vector_rrb_t *r);
+
+/**
+ * @brief Number of elements in a version.
+ *
+ * @param r Version.
+ * @return Number of elements, 0 on error.
+ */
+size_t vector_rrb_len(const vector_rrb_t *r);
+
+/**
+ * @brief Pointer to the element at index. O(log n).
+ *
+ * @param r Version.
+ * @param index Element index.
+ * @return Pointer to the element, NULL if out of range.
+ */
+const void *vector_rrb_at(const vector_rrb_t *r, size_t index);
+
+/**
+ * @brief New version with the element at index replaced. O(log n).
+ *
+ * @param r Version.
+ * @param index Element index.
+ * @param item Pointer to the new value.
+ * @return vector_rrb_t* on success, NULL on failure.
+ */
+vector_rrb_t *vector_rrb_set(const vector_rrb_t *r, size_t index, const void *item);
+
+/**
+ * @brief New version with item appended. O(log n).
+ *
+ * @param r Version.
+ * @param item Pointer to the item to copy in.
+ * @return vector_rrb_t* on success, NULL on failure.
+ */
+vector_rrb_t *vector_rrb_push(const vector_rrb_t *r, const void *item);
+
+/**
+ * @brief New version holding elements [begin, end). O(log n).
+ *
+ * @param r Version.
+ * @param begin First index to keep.
+ * @param end One past the last index to keep.
+ * @return vector_rrb_t* on success, NULL on failure or if the range is out of bounds.
+ */
+vector_rrb_t *vector_rrb_slice(const vector_rrb_t *r, size_t begin, size_t end);
+
+/**
+ * @brief New version holding the elements of x followed by those of y. O(log n).
+ *
+ * Nodes along the seam are rebalanced so lookups stay O(log n) after any
+ * sequence of slices and concatenations.
+ *
+ * @param x Left version.
+ * @param y Right version, same element size and allocator as x.
+ * @return vector_rrb_t* on success, NULL on failure.
+ */
+vector_rrb_t *vector_rrb_concat(const vector_rrb_t *x, const vector_rrb_t *y);
+
+#endif /* _VECTOR_RRB_H */
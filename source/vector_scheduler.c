@@ -0,0 +1,508 @@
+#include "vector_scheduler.h"
+#include "vector_deque.h"
+#include "vector_internal.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define VECTOR_SCHEDULER_DEQUE_CAP 64 /* initial deque buffer, power of two */
+
+typedef struct vector_task_t
+{
+    vector_task_fn_t fn;
+    void *arg;
+    vector_task_group_t *group;
+} vector_task_t;
+
+typedef _Atomic(vector_task_t *) vector_task_slot_t;
+
+/*
+ * Chase-Lev deque, after "Correct and Efficient Work-Stealing for Weak Memory
+ * Models" (Le et al.). The owner pushes and takes at bottom, thieves CAS top.
+ * Buffers are vailed vectors; outgrown ones are kept until the scheduler is
+ * destroyed because a thief may still be reading them.
+ */
+typedef struct
+{
+    atomic_long top;
+    byte_t pad0[VECTOR_CACHE_LINE - sizeof(atomic_long)];
+    atomic_long bottom;
+    _Atomic(vector_task_slot_t *) buf;
+    vector_task_slot_t **retired; /* vailed vector of outgrown buffers */
+    vector_scheduler_t *sched;
+    pthread_t thread;
+    unsigned rng;
+    byte_t pad1[VECTOR_CACHE_LINE];
+} vector_scheduler_worker_t;
+
+struct vector_scheduler_t
+{
+    allocator_t *a;
+    size_t threads;
+    vector_scheduler_worker_t *workers;
+
+    pthread_mutex_t inject_lock;
+    vector_task_t **inject; /* vailed deque, tasks from outside the pool */
+    atomic_size_t injected;
+
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t sleep_cond;
+    atomic_size_t epoch; /* bumped on every spawn */
+    atomic_size_t sleepers;
+    int stop;
+};
+
+static _Thread_local vector_scheduler_worker_t *current_worker;
+
+static vector_task_slot_t *vector_scheduler_grow(vector_scheduler_t *s, vector_scheduler_worker_t *w,
+                                                 vector_task_slot_t *old, long top, long bottom)
+{
+    size_t cap = VECTOR_HEADER(old)->cap;
+    vector_task_slot_t *buf = vector_init(sizeof(vector_task_slot_t), cap * 2, s->a);
+    if (!buf)
+        return NULL;
+    long i;
+    for (i = top; i < bottom; i++)
+        atomic_store_explicit(&buf[i & (cap * 2 - 1)],
+                              atomic_load_explicit(&old[i & (cap - 1)], memory_order_relaxed),
+                              memory_order_relaxed);
+    size_t before, after;
+    vector_get_len(w->retired, &before);
+    vector_push_back(w->retired, old);
+    vector_get_len(w->retired, &after);
+    if (after == before)
+    {
+        vector_free(buf); /* cannot retire safely, keep the old buffer */
+        return NULL;
+    }
+    atomic_store_explicit(&w->buf, buf, memory_order_release);
+    return buf;
+}
+
+static vector_status_t vector_scheduler_push(vector_scheduler_worker_t *w, vector_task_t *task)
+{
+    long b = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&w->top, memory_order_acquire);
+    vector_task_slot_t *buf = atomic_load_explicit(&w->buf, memory_order_relaxed);
+    size_t cap = VECTOR_HEADER(buf)->cap;
+    if (b - t > (long)cap - 1)
+    {
+        buf = vector_scheduler_grow(w->sched, w, buf, t, b);
+        if (!buf)
+            return VEC_ERR;
+        cap *= 2;
+    }
+    atomic_store_explicit(&buf[b & (cap - 1)], task, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+    return VEC_OK;
+}
+
+static vector_task_t *vector_scheduler_take(vector_scheduler_worker_t *w)
+{
+    long b = atomic_load_explicit(&w->bottom, memory_order_relaxed) - 1;
+    vector_task_slot_t *buf = atomic_load_explicit(&w->buf, memory_order_relaxed);
+    atomic_store_explicit(&w->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&w->top, memory_order_relaxed);
+    vector_task_t *task = NULL;
+    if (t <= b)
+    {
+        task = atomic_load_explicit(&buf[b & (VECTOR_HEADER(buf)->cap - 1)], memory_order_relaxed);
+        if (t == b)
+        {
+            /* Last item, race the thieves for it */
+            if (!atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+                task = NULL;
+            atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+        }
+    }
+    else
+    {
+        atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static vector_task_t *vector_scheduler_steal(vector_scheduler_worker_t *w)
+{
+    long t = atomic_load_explicit(&w->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&w->bottom, memory_order_acquire);
+    if (t >= b)
+        return NULL;
+    vector_task_slot_t *buf = atomic_load_explicit(&w->buf, memory_order_acquire);
+    vector_task_t *task = atomic_load_explicit(&buf[t & (VECTOR_HEADER(buf)->cap - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+        return NULL; /* lost the race, caller moves on */
+    return task;
+}
+
+/* Own deque first, then the injection queue, then one round of stealing */
+static vector_task_t *vector_scheduler_find(vector_scheduler_t *s, vector_scheduler_worker_t *self)
+{
+    vector_task_t *task = NULL;
+    if (self && (task = vector_scheduler_take(self)))
+        return task;
+
+    if (atomic_load_explicit(&s->injected, memory_order_acquire))
+    {
+        pthread_mutex_lock(&s->inject_lock);
+        if (vector_deque_pop_front(s->inject, &task) == VEC_OK)
+            atomic_fetch_sub_explicit(&s->injected, 1, memory_order_relaxed);
+        else
+            task = NULL;
+        pthread_mutex_unlock(&s->inject_lock);
+        if (task)
+            return task;
+    }
+
+    size_t i, start = self ? (self->rng = self->rng * 1103515245u + 12345u) >> 8 : 0;
+    for (i = 0; i < s->threads; i++)
+    {
+        vector_scheduler_worker_t *victim = &s->workers[(start + i) % s->threads];
+        if (victim != self && (task = vector_scheduler_steal(victim)))
+            return task;
+    }
+    return NULL;
+}
+
+static void vector_scheduler_run(vector_scheduler_t *s, vector_task_t *task)
+{
+    vector_task_group_t *g = task->group;
+    task->fn(task->arg);
+    s->a->free(task);
+    atomic_fetch_sub_explicit(&g->pending, 1, memory_order_release);
+}
+
+static void *vector_scheduler_worker(void *arg)
+{
+    vector_scheduler_worker_t *self = arg;
+    vector_scheduler_t *s = self->sched;
+    current_worker = self;
+    for (;;)
+    {
+        size_t epoch = atomic_load(&s->epoch);
+        vector_task_t *task = vector_scheduler_find(s, self);
+        if (task)
+        {
+            vector_scheduler_run(s, task);
+            continue;
+        }
+
+        /* Sleep unless something was spawned since the scan started */
+        pthread_mutex_lock(&s->sleep_lock);
+        if (s->stop)
+        {
+            pthread_mutex_unlock(&s->sleep_lock);
+            break;
+        }
+        atomic_fetch_add(&s->sleepers, 1);
+        if (atomic_load(&s->epoch) == epoch)
+            pthread_cond_wait(&s->sleep_cond, &s->sleep_lock);
+        atomic_fetch_sub(&s->sleepers, 1);
+        pthread_mutex_unlock(&s->sleep_lock);
+    }
+    return NULL;
+}
+
+vector_scheduler_t *vector_scheduler_create(size_t threads, allocator_t *a)
+{
+    if (!a)
+    {
+        VECTOR_DEBUG_PERROR("Vector Scheduler Create: given null allocator.\n");
+        return NULL;
+    }
+    if (threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    vector_scheduler_t *s = a->malloc(sizeof(vector_scheduler_t));
+    vector_scheduler_worker_t *workers = a->malloc(threads * sizeof(vector_scheduler_worker_t));
+    vector_task_t **inject = vector_deque(vector_task_t *, a);
+    if (!s || !workers || !inject)
+    {
+        VECTOR_DEBUG_PERROR("Vector Scheduler Create: allocation failed.\n");
+        if (s)
+            a->free(s);
+        if (workers)
+            a->free(workers);
+        if (inject)
+            vector_deque_free(inject);
+        return NULL;
+    }
+
+    s->a = a;
+    s->threads = 0;
+    s->workers = workers;
+    s->inject = inject;
+    s->stop = 0;
+    atomic_init(&s->injected, 0);
+    atomic_init(&s->epoch, 0);
+    atomic_init(&s->sleepers, 0);
+    pthread_mutex_init(&s->inject_lock, NULL);
+    pthread_mutex_init(&s->sleep_lock, NULL);
+    pthread_cond_init(&s->sleep_cond, NULL);
+
+    /* Buffers first so thieves never see a worker without one */
+    size_t i;
+    for (i = 0; i < threads; i++)
+    {
+        vector_scheduler_worker_t *w = &workers[i];
+        atomic_init(&w->top, 0);
+        atomic_init(&w->bottom, 0);
+        atomic_init(&w->buf, vector_init(sizeof(vector_task_slot_t), VECTOR_SCHEDULER_DEQUE_CAP, a));
+        w->retired = vector(vector_task_slot_t *, a);
+        w->sched = s;
+        w->rng = (unsigned)i * 2654435761u + 1;
+        if (!atomic_load(&w->buf) || !w->retired)
+            break;
+    }
+    s->threads = i;
+    if (i < threads)
+    {
+        VECTOR_DEBUG_PERROR("Vector Scheduler Create: allocation failed.\n");
+        if (atomic_load(&workers[i].buf))
+            vector_free(atomic_load(&workers[i].buf));
+        if (workers[i].retired)
+            vector_free(workers[i].retired);
+        s->stop = 2; /* no threads to join */
+        vector_scheduler_destroy(s);
+        return NULL;
+    }
+
+    for (i = 0; i < threads; i++)
+    {
+        if (pthread_create(&workers[i].thread, NULL, vector_scheduler_worker, &workers[i]) != 0)
+        {
+            VECTOR_DEBUG_PERROR("Vector Scheduler Create: thread creation failed.\n");
+            break;
+        }
+    }
+    if (i < threads)
+    {
+        /* Join what started, then drop the rest */
+        size_t started = i;
+        pthread_mutex_lock(&s->sleep_lock);
+        s->stop = 1;
+        pthread_cond_broadcast(&s->sleep_cond);
+        pthread_mutex_unlock(&s->sleep_lock);
+        for (i = 0; i < started; i++)
+            pthread_join(workers[i].thread, NULL);
+        s->stop = 2; /* already joined */
+        vector_scheduler_destroy(s);
+        return NULL;
+    }
+    return s;
+}
+
+vector_status_t vector_scheduler_destroy(vector_scheduler_t *s)
+{
+    if (!s)
+    {
+        VECTOR_DEBUG_PERROR("Vector Scheduler Destroy: given null.\n");
+        return VEC_ERR;
+    }
+    size_t i, j, n;
+    if (s->stop == 0)
+    {
+        pthread_mutex_lock(&s->sleep_lock);
+        s->stop = 1;
+        pthread_cond_broadcast(&s->sleep_cond);
+        pthread_mutex_unlock(&s->sleep_lock);
+        for (i = 0; i < s->threads; i++)
+            pthread_join(s->workers[i].thread, NULL);
+    }
+
+    for (i = 0; i < s->threads; i++)
+    {
+        vector_scheduler_worker_t *w = &s->workers[i];
+        vector_get_len(w->retired, &n);
+        for (j = 0; j < n; j++)
+            vector_free(w->retired[j]);
+        vector_free(w->retired);
+        vector_free(atomic_load(&w->buf));
+    }
+    pthread_mutex_destroy(&s->inject_lock);
+    pthread_mutex_destroy(&s->sleep_lock);
+    pthread_cond_destroy(&s->sleep_cond);
+    vector_deque_free(s->inject);
+    s->a->free(s->workers);
+    s->a->free(s);
+    return VEC_OK;
+}
+
+static allocator_t vector_scheduler_default_allocator = {malloc, realloc, free};
+static vector_scheduler_t *vector_scheduler_default_instance;
+static pthread_once_t vector_scheduler_default_once = PTHREAD_ONCE_INIT;
+
+static void vector_scheduler_default_create(void)
+{
+    vector_scheduler_default_instance = vector_scheduler_create(0, &vector_scheduler_default_allocator);
+}
+
+vector_scheduler_t *vector_scheduler_default(void)
+{
+    pthread_once(&vector_scheduler_default_once, vector_scheduler_default_create);
+    return vector_scheduler_default_instance;
+}
+
+size_t vector_scheduler_threads(vector_scheduler_t *s)
+{
+    return s ? s->threads : 0;
+}
+
+void vector_task_group_init(vector_task_group_t *g)
+{
+    if (g)
+        atomic_init(&g->pending, 0);
+}
+
+vector_status_t vector_scheduler_spawn(vector_scheduler_t *s, vector_task_group_t *g, vector_task_fn_t fn, void *arg)
+{
+    if (!s || !g || !fn)
+    {
+        VECTOR_DEBUG_PERROR("Vector Scheduler Spawn: given null argument.\n");
+        return VEC_ERR;
+    }
+    vector_task_t *task = s->a->malloc(sizeof(vector_task_t));
+    if (!task)
+    {
+        VECTOR_DEBUG_PERROR("Vector Scheduler Spawn: allocation failed.\n");
+        return VEC_ERR;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->group = g;
+    atomic_fetch_add_explicit(&g->pending, 1, memory_order_relaxed);
+
+    vector_status_t status = VEC_OK;
+    if (current_worker && current_worker->sched == s)
+    {
+        status = vector_scheduler_push(current_worker, task);
+    }
+    else
+    {
+        size_t before, after;
+        pthread_mutex_lock(&s->inject_lock);
+        vector_get_len(s->inject, &before);
+        vector_deque_push_back(s->inject, task);
+        vector_get_len(s->inject, &after);
+        pthread_mutex_unlock(&s->inject_lock);
+        if (after == before)
+            status = VEC_ERR;
+        else
+            atomic_fetch_add_explicit(&s->injected, 1, memory_order_release);
+    }
+    if (status != VEC_OK)
+    {
+        VECTOR_DEBUG_PERROR("Vector Scheduler Spawn: queue growth failed.\n");
+        atomic_fetch_sub_explicit(&g->pending, 1, memory_order_relaxed);
+        s->a->free(task);
+        return status;
+    }
+
+    atomic_fetch_add(&s->epoch, 1);
+    if (atomic_load(&s->sleepers))
+    {
+        pthread_mutex_lock(&s->sleep_lock);
+        pthread_cond_signal(&s->sleep_cond);
+        pthread_mutex_unlock(&s->sleep_lock);
+    }
+    return VEC_OK;
+}
+
+void vector_scheduler_wait(vector_scheduler_t *s, vector_task_group_t *g)
+{
+    if (!s || !g)
+    {
+        VECTOR_DEBUG_PERROR("Vector Scheduler Wait: given null argument.\n");
+        return;
+    }
+    vector_scheduler_worker_t *self = current_worker && current_worker->sched == s ? current_worker : NULL;
+    while (atomic_load_explicit(&g->pending, memory_order_acquire) > 0)
+    {
+        vector_task_t *task = vector_scheduler_find(s, self);
+        if (task)
+            vector_scheduler_run(s, task);
+        else
+            sched_yield();
+    }
+}
+
+/* A piece of a vector_scheduler_for() range, split until it is at most grain long */
+typedef struct
+{
+    vector_scheduler_t *s;
+    vector_task_group_t *g;
+    void *vector;
+    vector_range_fn_t fn;
+    void *ctx;
+    size_t begin, end, grain;
+} vector_scheduler_range_t;
+
+static void vector_scheduler_range_task(void *arg)
+{
+    vector_scheduler_range_t *r = arg;
+    while (r->end - r->begin > r->grain)
+    {
+        size_t mid = r->begin + (r->end - r->begin) / 2;
+        vector_scheduler_range_t *half = r->s->a->malloc(sizeof(vector_scheduler_range_t));
+        if (!half)
+            break; /* run the rest here */
+        *half = *r;
+        half->begin = mid;
+        if (vector_scheduler_spawn(r->s, r->g, vector_scheduler_range_task, half) != VEC_OK)
+        {
+            r->s->a->free(half);
+            break;
+        }
+        r->end = mid;
+    }
+    r->fn(r->vector, r->begin, r->end, r->ctx);
+    r->s->a->free(r);
+}
+
+vector_status_t vector_scheduler_for(vector_scheduler_t *s, void *vector, vector_range_fn_t fn, void *ctx, size_t grain)
+{
+    if (!s)
+        s = vector_scheduler_default();
+    if (!s || !vector || !fn)
+    {
+        VECTOR_DEBUG_PERROR("Vector Scheduler For: given null argument.\n");
+        return VEC_ERR;
+    }
+    size_t len;
+    vector_get_len(vector, &len);
+    if (len == 0)
+        return VEC_OK;
+    if (grain == 0)
+        grain = len / (s->threads * 16) + 1;
+
+    vector_scheduler_range_t *root = s->a->malloc(sizeof(vector_scheduler_range_t));
+    if (!root)
+    {
+        VECTOR_DEBUG_PERROR("Vector Scheduler For: allocation failed.\n");
+        return VEC_ERR;
+    }
+    vector_task_group_t g;
+    vector_task_group_init(&g);
+    root->s = s;
+    root->g = &g;
+    root->vector = vector;
+    root->fn = fn;
+    root->ctx = ctx;
+    root->begin = 0;
+    root->end = len;
+    root->grain = grain;
+    if (vector_scheduler_spawn(s, &g, vector_scheduler_range_task, root) != VEC_OK)
+    {
+        s->a->free(root);
+        return VEC_ERR;
+    }
+    vector_scheduler_wait(s, &g);
+    return VEC_OK;
+}
@@ -0,0 +1,106 @@
+#ifndef _VECTOR_SCHEDULER_H
+#define _VECTOR_SCHEDULER_H
+
+#include "vector.h"
+#include "vector_parallel.h"
+
+#include <stdatomic.h>
+
+/**
+ * @brief Work-stealing thread pool.
+ *
+ * Every worker owns a Chase-Lev deque (its buffer is a vailed vector of task
+ * pointers). Workers pop their own newest task and steal the oldest task of a
+ * random victim when idle. Tasks spawned from outside the pool go through a
+ * shared injection queue.
+ */
+typedef struct vector_scheduler_t vector_scheduler_t;
+
+/**
+ * @brief Counts the unfinished tasks spawned into it. Initialize with vector_task_group_init().
+ */
+typedef struct
+{
+    atomic_size_t pending;
+} vector_task_group_t;
+
+/**
+ * @brief Task body.
+ */
+typedef void (*vector_task_fn_t)(void *arg);
+
+/**
+ * @brief Create a scheduler.
+ *
+ * @param threads Worker count, 0 for the number of online CPUs.
+ * @param a Allocator for tasks and deque buffers.
+ * @return vector_scheduler_t* on success, NULL on failure.
+ */
+vector_scheduler_t *vector_scheduler_create(size_t threads, allocator_t *a);
+
+/**
+ * @brief Stop and join the workers and free the scheduler. No task may be pending.
+ *
+ * @param s Scheduler.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_scheduler_destroy(vector_scheduler_t *s);
+
+/**
+ * @brief Process-wide scheduler with one worker per online CPU, created on first use.
+ *
+ * @return The shared scheduler, NULL if it could not be created.
+ */
+vector_scheduler_t *vector_scheduler_default(void);
+
+/**
+ * @brief Number of worker threads.
+ */
+size_t vector_scheduler_threads(vector_scheduler_t *s);
+
+/**
+ * @brief Reset a task group to zero pending tasks.
+ */
+void vector_task_group_init(vector_task_group_t *g);
+
+/**
+ * @brief Queue fn(arg) as part of group g.
+ *
+ * From a worker the task goes onto that worker's deque, from any other thread
+ * onto the injection queue. Tasks may spawn further tasks.
+ *
+ * @param s Scheduler.
+ * @param g Group the task belongs to.
+ * @param fn Task body.
+ * @param arg Argument for fn.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_scheduler_spawn(vector_scheduler_t *s, vector_task_group_t *g, vector_task_fn_t fn, void *arg);
+
+/**
+ * @brief Run queued tasks until every task of g has finished.
+ *
+ * Safe to call from inside a task (the caller keeps working instead of blocking).
+ *
+ * @param s Scheduler.
+ * @param g Group to wait for.
+ */
+void vector_scheduler_wait(vector_scheduler_t *s, vector_task_group_t *g);
+
+/**
+ * @brief Run fn over the vector's index range by recursive halving.
+ *
+ * Ranges larger than grain are split in two; one half is spawned and the
+ * other is split further by the same task, so idle workers steal the largest
+ * remaining pieces first. Suits uneven per-element cost.
+ *
+ * @param s Scheduler, NULL for vector_scheduler_default().
+ * @param vector Vector pointer.
+ * @param fn Range body, same shape as for vector_parallel_for().
+ * @param ctx User context passed to fn.
+ * @param grain Largest range run without splitting, 0 picks one.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_scheduler_for(vector_scheduler_t *s, void *vector, vector_range_fn_t fn, void *ctx, size_t grain);
+
+#endif /* _VECTOR_SCHEDULER_H */
@@ -0,0 +1,214 @@
+#ifndef _VECTOR_SOA_H
+#define _VECTOR_SOA_H
+
+#include "vector.h"
+
+#include <string.h>
+
+/* Every column starts on its own cache line */
+#define VECTOR_SOA_ALIGN 64
+
+/* Generated functions a program does not call are not worth a warning */
+#if defined(__GNUC__)
+#define VECTOR_SOA_FN static __attribute__((unused))
+#else
+#define VECTOR_SOA_FN static
+#endif
+
+#define VECTOR_SOA_ROUND(bytes) (((bytes) + VECTOR_SOA_ALIGN - 1) & ~(size_t)(VECTOR_SOA_ALIGN - 1))
+
+/**
+ * @brief Generate a struct-of-arrays vector for records of type T.
+ *
+ * FIELDS is an X-macro listing the columns as X(type, member); every member
+ * must also exist in T. All columns share one length and capacity and live in
+ * a single allocation, each column contiguous and cache line aligned, so a
+ * loop over one member only streams that member's bytes.
+ *
+ * Defines the type vector_soa_<name>_t, with one pointer per column named
+ * after its member, and static functions
+ * - vector_soa_<name>_init(s, cap, a) / _free(s)
+ * - vector_soa_<name>_reserve(s, cap): grow every column together
+ * - vector_soa_<name>_set_len(s, len): grow if needed, new rows uninitialized
+ * - vector_soa_<name>_push(s, &record) / _get(s, i, &record) / _set(s, i, &record)
+ * - vector_soa_<name>_from_aos(s, vector): replace contents with a vailed vector of T
+ * - vector_soa_<name>_to_aos(s): new vailed vector of T
+ *
+ * @param name Suffix for the generated type and functions.
+ * @param T Record (array of structs) type.
+ * @param FIELDS X-macro listing the columns.
+ *
+ * Example:
+ * @code
+ * typedef struct { uint64_t id; float x, y, z; uint8_t flags; } particle_t;
+ * #define PARTICLE_FIELDS(X) X(uint64_t, id) X(float, x) X(float, y) X(float, z) X(uint8_t, flags)
+ * VECTOR_SOA_DEFINE(particle, particle_t, PARTICLE_FIELDS)
+ * ...
+ * vector_soa_particle_t ps;
+ * vector_soa_particle_init(&ps, 0, &a);
+ * for (i = 0; i < ps.len; i++)
+ *     ps.x[i] += 1.0f;
+ * @endcode
+ */
+#define VECTOR_SOA_DEFINE(name, T, FIELDS)                                                               \
+    typedef struct                                                                                       \
+    {                                                                                                    \
+        size_t len;                                                                                      \
+        size_t cap;                                                                                      \
+        allocator_t *a;                                                                                  \
+        void *block; /* the one allocation behind every column */                                        \
+        FIELDS(VECTOR_SOA_X_COLUMN)                                                                      \
+    } vector_soa_##name##_t;                                                                             \
+                                                                                                         \
+    VECTOR_SOA_FN vector_status_t vector_soa_##name##_reserve(vector_soa_##name##_t *_s, size_t _cap)    \
+    {                                                                                                    \
+        if (!_s)                                                                                         \
+        {                                                                                                \
+            VECTOR_DEBUG_PERROR("Vector SoA Reserve: given null vector.\n");                             \
+            return VEC_ERR;                                                                              \
+        }                                                                                                \
+        if (_cap <= _s->cap)                                                                             \
+            return VEC_OK;                                                                               \
+        size_t _bytes = 0 FIELDS(VECTOR_SOA_X_BYTES);                                                    \
+        unsigned char *_block = _s->a->malloc(_bytes + VECTOR_SOA_ALIGN - 1);                            \
+        if (!_block)                                                                                     \
+        {                                                                                                \
+            VECTOR_DEBUG_PERROR("Vector SoA Reserve: allocation failed.\n");                             \
+            return VEC_ERR;                                                                              \
+        }                                                                                                \
+        unsigned char *_p = (unsigned char *)VECTOR_SOA_ROUND((uintptr_t)_block);                        \
+        FIELDS(VECTOR_SOA_X_MOVE)                                                                        \
+        if (_s->block)                                                                                   \
+            _s->a->free(_s->block);                                                                      \
+        _s->block = _block;                                                                              \
+        _s->cap = _cap;                                                                                  \
+        return VEC_OK;                                                                                   \
+    }                                                                                                    \
+                                                                                                         \
+    VECTOR_SOA_FN vector_status_t vector_soa_##name##_init(vector_soa_##name##_t *_s, size_t _cap,       \
+                                                           allocator_t *_a)                              \
+    {                                                                                                    \
+        if (!_s || !_a)                                                                                  \
+        {                                                                                                \
+            VECTOR_DEBUG_PERROR("Vector SoA Init: given null vector or allocator.\n");                   \
+            return VEC_ERR;                                                                              \
+        }                                                                                                \
+        memset(_s, 0, sizeof(*_s));                                                                      \
+        _s->a = _a;                                                                                      \
+        return vector_soa_##name##_reserve(_s, _cap);                                                    \
+    }                                                                                                    \
+                                                                                                         \
+    VECTOR_SOA_FN vector_status_t vector_soa_##name##_free(vector_soa_##name##_t *_s)                    \
+    {                                                                                                    \
+        if (!_s || !_s->a)                                                                               \
+        {                                                                                                \
+            VECTOR_DEBUG_PERROR("Vector SoA Free: given null or uninitialized vector.\n");               \
+            return VEC_ERR;                                                                              \
+        }                                                                                                \
+        if (_s->block)                                                                                   \
+            _s->a->free(_s->block);                                                                      \
+        memset(_s, 0, sizeof(*_s));                                                                      \
+        return VEC_OK;                                                                                   \
+    }                                                                                                    \
+                                                                                                         \
+    VECTOR_SOA_FN vector_status_t vector_soa_##name##_set_len(vector_soa_##name##_t *_s, size_t _len)    \
+    {                                                                                                    \
+        if (!_s)                                                                                         \
+        {                                                                                                \
+            VECTOR_DEBUG_PERROR("Vector SoA Set Len: given null vector.\n");                             \
+            return VEC_ERR;                                                                              \
+        }                                                                                                \
+        if (_len > _s->cap && vector_soa_##name##_reserve(_s, _len) != VEC_OK)                           \
+            return VEC_ERR;                                                                              \
+        _s->len = _len;                                                                                  \
+        return VEC_OK;                                                                                   \
+    }                                                                                                    \
+                                                                                                         \
+    VECTOR_SOA_FN vector_status_t vector_soa_##name##_push(vector_soa_##name##_t *_s, const T *_rec)     \
+    {                                                                                                    \
+        if (!_s || !_rec)                                                                                \
+        {                                                                                                \
+            VECTOR_DEBUG_PERROR("Vector SoA Push: given null argument.\n");                              \
+            return VEC_ERR;                                                                              \
+        }                                                                                                \
+        if (_s->len == _s->cap && vector_soa_##name##_reserve(_s, (_s->cap + 1) * 2) != VEC_OK)          \
+            return VEC_ERR;                                                                              \
+        size_t _i = _s->len++;                                                                           \
+        FIELDS(VECTOR_SOA_X_STORE)                                                                       \
+        return VEC_OK;                                                                                   \
+    }                                                                                                    \
+                                                                                                         \
+    VECTOR_SOA_FN vector_status_t vector_soa_##name##_get(const vector_soa_##name##_t *_s, size_t _i,    \
+                                                          T *_out)                                       \
+    {                                                                                                    \
+        if (!_s || !_out || _i >= _s->len)                                                               \
+        {                                                                                                \
+            VECTOR_DEBUG_PERROR("Vector SoA Get: given null argument or index out of bounds.\n");        \
+            return !_s || !_out ? VEC_ERR : VEC_INDEX_OOB;                                               \
+        }                                                                                                \
+        FIELDS(VECTOR_SOA_X_LOAD)                                                                        \
+        return VEC_OK;                                                                                   \
+    }                                                                                                    \
+                                                                                                         \
+    VECTOR_SOA_FN vector_status_t vector_soa_##name##_set(vector_soa_##name##_t *_s, size_t _i,          \
+                                                          const T *_rec)                                 \
+    {                                                                                                    \
+        if (!_s || !_rec || _i >= _s->len)                                                               \
+        {                                                                                                \
+            VECTOR_DEBUG_PERROR("Vector SoA Set: given null argument or index out of bounds.\n");        \
+            return !_s || !_rec ? VEC_ERR : VEC_INDEX_OOB;                                               \
+        }                                                                                                \
+        FIELDS(VECTOR_SOA_X_STORE)                                                                       \
+        return VEC_OK;                                                                                   \
+    }                                                                                                    \
+                                                                                                         \
+    VECTOR_SOA_FN vector_status_t vector_soa_##name##_from_aos(vector_soa_##name##_t *_s, const T *_aos) \
+    {                                                                                                    \
+        size_t _n, _i;                                                                                   \
+        if (!_s || vector_get_len((void *)_aos, &_n) != VEC_OK)                                          \
+        {                                                                                                \
+            VECTOR_DEBUG_PERROR("Vector SoA From AoS: given null argument.\n");                          \
+            return VEC_ERR;                                                                              \
+        }                                                                                                \
+        if (vector_soa_##name##_set_len(_s, _n) != VEC_OK)                                               \
+            return VEC_ERR;                                                                              \
+        FIELDS(VECTOR_SOA_X_SCATTER) /* one pass per column */                                           \
+        return VEC_OK;                                                                                   \
+    }                                                                                                    \
+                                                                                                         \
+    VECTOR_SOA_FN T *vector_soa_##name##_to_aos(const vector_soa_##name##_t *_s)                         \
+    {                                                                                                    \
+        size_t _i;                                                                                       \
+        if (!_s || !_s->a)                                                                               \
+        {                                                                                                \
+            VECTOR_DEBUG_PERROR("Vector SoA To AoS: given null or uninitialized vector.\n");             \
+            return NULL;                                                                                 \
+        }                                                                                                \
+        T *_aos = vector_init(sizeof(T), _s->len, _s->a);                                                \
+        if (!_aos)                                                                                       \
+            return NULL;                                                                                 \
+        memset(_aos, 0, _s->len * sizeof(T)); /* members outside FIELDS */                               \
+        FIELDS(VECTOR_SOA_X_GATHER)                                                                      \
+        internal_vector_set_len(_aos, _s->len);                                                          \
+        return _aos;                                                                                     \
+    }
+
+/* Internal X callbacks, they rely on the local names used above */
+
+#define VECTOR_SOA_X_COLUMN(FT, member) FT *member;
+#define VECTOR_SOA_X_BYTES(FT, member) +VECTOR_SOA_ROUND(sizeof(FT) * _cap)
+#define VECTOR_SOA_X_MOVE(FT, member)                          \
+    if (_s->len)                                               \
+        memcpy(_p, _s->member, _s->len * sizeof(FT));          \
+    _s->member = (FT *)_p;                                     \
+    _p += VECTOR_SOA_ROUND(sizeof(FT) * _cap);
+#define VECTOR_SOA_X_STORE(FT, member) _s->member[_i] = _rec->member;
+#define VECTOR_SOA_X_LOAD(FT, member) _out->member = _s->member[_i];
+#define VECTOR_SOA_X_SCATTER(FT, member) \
+    for (_i = 0; _i < _n; _i++)          \
+        _s->member[_i] = _aos[_i].member;
+#define VECTOR_SOA_X_GATHER(FT, member) \
+    for (_i = 0; _i < _s->len; _i++)    \
+        _aos[_i].member = _s->member[_i];
+
+#endif /* _VECTOR_SOA_H */
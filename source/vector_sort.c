@@ -0,0 +1,202 @@
+#include "vector_sort.h"
+#include "vector_internal.h"
+#include "vector_scheduler.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define VECTOR_SORT_LEAF 8192  /* runs at most this long are sorted by ops->sort */
+#define VECTOR_SORT_MERGE 8192 /* merges at most this long run sequentially */
+
+/* Generic callbacks on opaque elements of ops->tsize bytes */
+
+static void vector_sort_generic_sort(void *base, size_t n, const vector_sort_ops_t *ops)
+{
+    qsort(base, n, ops->tsize, ops->cmp);
+}
+
+static void vector_sort_generic_merge(const void *xv, size_t nx, const void *yv, size_t ny, void *outv, const vector_sort_ops_t *ops)
+{
+    const byte_t *x = xv, *y = yv;
+    byte_t *out = outv;
+    size_t ts = ops->tsize;
+    while (nx && ny)
+    {
+        if (ops->cmp(y, x) < 0)
+        {
+            memcpy(out, y, ts);
+            y += ts;
+            ny--;
+        }
+        else
+        {
+            memcpy(out, x, ts);
+            x += ts;
+            nx--;
+        }
+        out += ts;
+    }
+    memcpy(out, x, nx * ts);
+    memcpy(out + nx * ts, y, ny * ts);
+}
+
+static size_t vector_sort_generic_lower_bound(const void *base, size_t n, const void *key, const vector_sort_ops_t *ops)
+{
+    size_t lo = 0;
+    while (n > 0)
+    {
+        size_t half = n / 2;
+        if (ops->cmp((const byte_t *)base + (lo + half) * ops->tsize, key) < 0)
+        {
+            lo += half + 1;
+            n -= half + 1;
+        }
+        else
+            n = half;
+    }
+    return lo;
+}
+
+/* Task arguments live on the spawning task's stack, which waits for them */
+typedef struct
+{
+    vector_scheduler_t *s;
+    const vector_sort_ops_t *ops;
+    const byte_t *x, *y;
+    byte_t *out;
+    size_t nx, ny;
+} vector_sort_merge_t;
+
+typedef struct
+{
+    vector_scheduler_t *s;
+    const vector_sort_ops_t *ops;
+    byte_t *data, *scratch;
+    size_t n;
+    int into_scratch; /* leave the sorted run in scratch instead of data */
+} vector_sort_task_t;
+
+/*
+ * Merge two sorted runs into out. The longer run is split at its median and the
+ * shorter one at the matching lower bound; the two independent halves become
+ * tasks until they are small enough to merge sequentially.
+ */
+static void vector_sort_merge_task(void *arg)
+{
+    vector_sort_merge_t *m = arg;
+    const vector_sort_ops_t *ops = m->ops;
+    if (m->nx + m->ny <= VECTOR_SORT_MERGE)
+    {
+        ops->merge(m->x, m->nx, m->y, m->ny, m->out, ops);
+        return;
+    }
+    if (m->nx < m->ny)
+    {
+        const byte_t *t = m->x;
+        size_t tn = m->nx;
+        m->x = m->y;
+        m->nx = m->ny;
+        m->y = t;
+        m->ny = tn;
+    }
+    size_t xm = m->nx / 2;
+    size_t ym = ops->lower_bound(m->y, m->ny, m->x + xm * ops->tsize, ops);
+
+    vector_sort_merge_t lo = *m, hi = *m;
+    lo.nx = xm;
+    lo.ny = ym;
+    hi.x = m->x + xm * ops->tsize;
+    hi.nx = m->nx - xm;
+    hi.y = m->y + ym * ops->tsize;
+    hi.ny = m->ny - ym;
+    hi.out = m->out + (xm + ym) * ops->tsize;
+
+    vector_task_group_t g;
+    vector_task_group_init(&g);
+    if (vector_scheduler_spawn(m->s, &g, vector_sort_merge_task, &lo) != VEC_OK)
+        vector_sort_merge_task(&lo);
+    vector_sort_merge_task(&hi);
+    vector_scheduler_wait(m->s, &g);
+}
+
+static void vector_sort_task(void *arg)
+{
+    vector_sort_task_t *t = arg;
+    const vector_sort_ops_t *ops = t->ops;
+    size_t ts = ops->tsize;
+    if (t->n <= VECTOR_SORT_LEAF)
+    {
+        ops->sort(t->data, t->n, ops);
+        if (t->into_scratch)
+            memcpy(t->scratch, t->data, t->n * ts);
+        return;
+    }
+
+    /* Sort the halves into the other buffer, then merge them back */
+    size_t mid = t->n / 2;
+    vector_sort_task_t lo = *t, hi = *t;
+    lo.n = mid;
+    lo.into_scratch = !t->into_scratch;
+    hi.data = t->data + mid * ts;
+    hi.scratch = t->scratch + mid * ts;
+    hi.n = t->n - mid;
+    hi.into_scratch = !t->into_scratch;
+
+    vector_task_group_t g;
+    vector_task_group_init(&g);
+    if (vector_scheduler_spawn(t->s, &g, vector_sort_task, &lo) != VEC_OK)
+        vector_sort_task(&lo);
+    vector_sort_task(&hi);
+    vector_scheduler_wait(t->s, &g);
+
+    const byte_t *src = t->into_scratch ? t->data : t->scratch;
+    vector_sort_merge_t m = {t->s, ops, src, src + mid * ts, t->into_scratch ? t->scratch : t->data, mid, t->n - mid};
+    vector_sort_merge_task(&m);
+}
+
+vector_status_t internal_vector_parallel_sort(void *vector, const vector_sort_ops_t *ops)
+{
+    if (!vector || !ops)
+    {
+        VECTOR_DEBUG_PERROR("Vector Parallel Sort: given null vector or ops.\n");
+        return VEC_ERR;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    if (VECTOR_IS_SHARED(hdr))
+    {
+        VECTOR_DEBUG_PERROR("Vector Parallel Sort: vector is shared, call vector_unique first.\n");
+        return VEC_SHARED;
+    }
+    vector_scheduler_t *s = NULL;
+    byte_t *scratch = NULL;
+    if (hdr->len >= VECTOR_SORT_PARALLEL_MIN)
+        s = vector_scheduler_default();
+    if (s)
+        scratch = hdr->a->malloc(hdr->len * hdr->tsize);
+    if (!scratch)
+    {
+        /* Short or out of memory: sort sequentially in place */
+        ops->sort(vector, hdr->len, ops);
+        return VEC_OK;
+    }
+
+    vector_sort_task_t root = {s, ops, vector, scratch, hdr->len, 0};
+    vector_task_group_t g;
+    vector_task_group_init(&g);
+    if (vector_scheduler_spawn(s, &g, vector_sort_task, &root) != VEC_OK)
+        vector_sort_task(&root);
+    vector_scheduler_wait(s, &g);
+    hdr->a->free(scratch);
+    return VEC_OK;
+}
+
+vector_status_t vector_parallel_sort(void *vector, int (*cmp)(const void *, const void *))
+{
+    if (!vector || !cmp)
+    {
+        VECTOR_DEBUG_PERROR("Vector Parallel Sort: given null vector or comparator.\n");
+        return VEC_ERR;
+    }
+    vector_sort_ops_t ops = {VECTOR_HEADER(vector)->tsize, cmp, vector_sort_generic_sort,
+                             vector_sort_generic_merge, vector_sort_generic_lower_bound};
+    return internal_vector_parallel_sort(vector, &ops);
+}
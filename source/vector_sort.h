@@ -0,0 +1,180 @@
+#ifndef _VECTOR_SORT_H
+#define _VECTOR_SORT_H
+
+#include "vector.h"
+
+/* Vectors shorter than this are sorted sequentially without scratch space */
+#define VECTOR_SORT_PARALLEL_MIN 32768
+
+#if defined(__GNUC__)
+#define VECTOR_SORT_FN static __attribute__((unused))
+#else
+#define VECTOR_SORT_FN static
+#endif
+
+/**
+ * @brief Callbacks the parallel merge sort is built from.
+ *
+ * vector_parallel_sort() fills these with qsort and memcpy based versions;
+ * VECTOR_SORT_DEFINE() generates typed ones so the inner loops compare inline.
+ */
+typedef struct vector_sort_ops_t
+{
+    size_t tsize;
+    int (*cmp)(const void *, const void *); /* only used by the generic callbacks */
+    void (*sort)(void *base, size_t n, const struct vector_sort_ops_t *ops);
+    void (*merge)(const void *x, size_t nx, const void *y, size_t ny, void *out, const struct vector_sort_ops_t *ops);
+    size_t (*lower_bound)(const void *base, size_t n, const void *key, const struct vector_sort_ops_t *ops);
+} vector_sort_ops_t;
+
+/**
+ * @brief Sort a vector in place using all workers of the default scheduler.
+ *
+ * Parallel merge sort: halves are sorted as separate tasks and merged by a
+ * parallel merge that splits on the median of the longer run. Scratch space
+ * of len elements comes from the vector's allocator. Below
+ * VECTOR_SORT_PARALLEL_MIN elements this is a plain qsort(). Not stable.
+ *
+ * @param vector Vector pointer.
+ * @param cmp qsort-style comparator.
+ * @return VEC_OK on success, VEC_SHARED if the vector is shared, VEC_ERR on error
+ */
+vector_status_t vector_parallel_sort(void *vector, int (*cmp)(const void *, const void *));
+
+/**
+ * @brief Run the parallel merge sort with custom callbacks. Used by VECTOR_SORT_DEFINE().
+ */
+vector_status_t internal_vector_parallel_sort(void *vector, const vector_sort_ops_t *ops);
+
+/**
+ * @brief Generate typed sorts for vectors of T.
+ *
+ * Defines static functions
+ * - vector_sort_<name>(T *v): sequential in-place quicksort with inline comparisons
+ * - vector_parallel_sort_<name>(T *v): parallel merge sort built on the typed leaves,
+ *   returns VEC_SHARED without sorting if the vector is shared
+ *
+ * Both work in place. vector_sort_<name> does not check for sharing, so call
+ * vector_unique() first on a vector that may be shared.
+ *
+ * @param name Suffix for the generated functions.
+ * @param T Element type.
+ * @param LESS Function-like macro or function, LESS(a, b) is nonzero when a sorts before b.
+ *
+ * Example:
+ * @code
+ * #define INT_LESS(a, b) ((a) < (b))
+ * VECTOR_SORT_DEFINE(int, int, INT_LESS)
+ * ...
+ * vector_parallel_sort_int(vec);
+ * @endcode
+ */
+#define VECTOR_SORT_DEFINE(name, T, LESS)                                                          \
+    VECTOR_SORT_FN void vector_sort_##name##_range(T *v, size_t n)                                \
+    {                                                                                             \
+        while (n > 16)                                                                            \
+        {                                                                                         \
+            T t, pivot;                                                                           \
+            size_t m = n / 2;                                                                     \
+            if (LESS(v[m], v[0]))                                                                 \
+                t = v[m], v[m] = v[0], v[0] = t;                                                  \
+            if (LESS(v[n - 1], v[m]))                                                             \
+            {                                                                                     \
+                t = v[m], v[m] = v[n - 1], v[n - 1] = t;                                          \
+                if (LESS(v[m], v[0]))                                                             \
+                    t = v[m], v[m] = v[0], v[0] = t;                                              \
+            }                                                                                     \
+            pivot = v[m];                                                                         \
+            size_t i = 0, j = n - 1;                                                              \
+            for (;;) /* Hoare partition, median of three keeps both scans in bounds */            \
+            {                                                                                     \
+                while (LESS(v[i], pivot))                                                         \
+                    i++;                                                                          \
+                while (LESS(pivot, v[j]))                                                         \
+                    j--;                                                                          \
+                if (i >= j)                                                                       \
+                    break;                                                                        \
+                t = v[i], v[i] = v[j], v[j] = t;                                                  \
+                i++;                                                                              \
+                j--;                                                                              \
+            }                                                                                     \
+            if (j + 1 < n - j - 1) /* recurse into the smaller side */                            \
+            {                                                                                     \
+                vector_sort_##name##_range(v, j + 1);                                             \
+                v += j + 1;                                                                       \
+                n -= j + 1;                                                                       \
+            }                                                                                     \
+            else                                                                                  \
+            {                                                                                     \
+                vector_sort_##name##_range(v + j + 1, n - j - 1);                                 \
+                n = j + 1;                                                                        \
+            }                                                                                     \
+        }                                                                                         \
+        size_t i, j;                                                                              \
+        for (i = 1; i < n; i++)                                                                   \
+        {                                                                                         \
+            T x = v[i];                                                                           \
+            for (j = i; j > 0 && LESS(x, v[j - 1]); j--)                                          \
+                v[j] = v[j - 1];                                                                  \
+            v[j] = x;                                                                             \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    VECTOR_SORT_FN void vector_sort_##name##_leaf(void *base, size_t n,                           \
+                                                  const vector_sort_ops_t *ops)                   \
+    {                                                                                             \
+        (void)ops;                                                                                \
+        vector_sort_##name##_range((T *)base, n);                                                 \
+    }                                                                                             \
+                                                                                                  \
+    VECTOR_SORT_FN void vector_sort_##name##_merge(const void *xv, size_t nx,                     \
+                                                   const void *yv, size_t ny, void *outv,         \
+                                                   const vector_sort_ops_t *ops)                  \
+    {                                                                                             \
+        const T *x = xv, *xe = x + nx, *y = yv, *ye = y + ny;                                     \
+        T *out = outv;                                                                            \
+        (void)ops;                                                                                \
+        while (x < xe && y < ye)                                                                  \
+            *out++ = LESS(*y, *x) ? *y++ : *x++;                                                  \
+        while (x < xe)                                                                            \
+            *out++ = *x++;                                                                        \
+        while (y < ye)                                                                            \
+            *out++ = *y++;                                                                        \
+    }                                                                                             \
+                                                                                                  \
+    VECTOR_SORT_FN size_t vector_sort_##name##_lower_bound(const void *basev, size_t n,           \
+                                                           const void *keyv,                      \
+                                                           const vector_sort_ops_t *ops)          \
+    {                                                                                             \
+        const T *base = basev;                                                                    \
+        size_t lo = 0;                                                                            \
+        (void)ops;                                                                                \
+        while (n > 0)                                                                             \
+        {                                                                                         \
+            size_t half = n / 2;                                                                  \
+            if (LESS(base[lo + half], *(const T *)keyv))                                          \
+            {                                                                                     \
+                lo += half + 1;                                                                   \
+                n -= half + 1;                                                                    \
+            }                                                                                     \
+            else                                                                                  \
+                n = half;                                                                         \
+        }                                                                                         \
+        return lo;                                                                                \
+    }                                                                                             \
+                                                                                                  \
+    VECTOR_SORT_FN void vector_sort_##name(T *v)                                                  \
+    {                                                                                             \
+        size_t len;                                                                               \
+        if (vector_get_len(v, &len) == VEC_OK)                                                    \
+            vector_sort_##name##_range(v, len);                                                   \
+    }                                                                                             \
+                                                                                                  \
+    VECTOR_SORT_FN vector_status_t vector_parallel_sort_##name(T *v)                              \
+    {                                                                                             \
+        vector_sort_ops_t ops = {sizeof(T), NULL, vector_sort_##name##_leaf,                      \
+                                 vector_sort_##name##_merge, vector_sort_##name##_lower_bound};   \
+        return internal_vector_parallel_sort(v, &ops);                                            \
+    }
+
+#endif /* _VECTOR_SORT_H */
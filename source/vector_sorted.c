@@ -0,0 +1,217 @@
+#include "vector_sorted.h"
+#include "vector_internal.h"
+#include "vector_sort.h"
+#include <string.h>
+
+static size_t vector_sorted_log2(size_t x)
+{
+#if defined(__GNUC__)
+    return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(x);
+#else
+    size_t r = 0;
+    while (x >>= 1)
+        r++;
+    return r;
+#endif
+}
+
+static size_t vector_sorted_ctz(size_t x)
+{
+#if defined(__GNUC__)
+    return (size_t)__builtin_ctzll(x);
+#else
+    size_t r = 0;
+    while (!(x & 1))
+    {
+        x >>= 1;
+        r++;
+    }
+    return r;
+#endif
+}
+
+size_t vector_lower_bound(const void *vector, const void *key, int (*cmp)(const void *, const void *))
+{
+    if (!vector || !key || !cmp)
+    {
+        VECTOR_DEBUG_PERROR("Vector Lower Bound: given null argument.\n");
+        return 0;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    size_t n = hdr->len, ts = hdr->tsize;
+    if (n == 0)
+        return 0;
+    const byte_t *base = vector;
+    while (n > 1)
+    {
+        size_t half = n / 2;
+        VECTOR_SORTED_PREFETCH(base + (half / 2) * ts);
+        VECTOR_SORTED_PREFETCH(base + (half + half / 2) * ts);
+        base = cmp(base + half * ts, key) < 0 ? base + half * ts : base;
+        n -= half;
+    }
+    return (size_t)(base - (const byte_t *)vector) / ts + (cmp(base, key) < 0);
+}
+
+void *vector_sorted_find(const void *vector, const void *key, int (*cmp)(const void *, const void *))
+{
+    if (!vector || !key || !cmp)
+    {
+        VECTOR_DEBUG_PERROR("Vector Sorted Find: given null argument.\n");
+        return NULL;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    size_t i = vector_lower_bound(vector, key, cmp);
+    byte_t *item = (byte_t *)vector + i * hdr->tsize;
+    return i < hdr->len && cmp(item, key) == 0 ? item : NULL;
+}
+
+vector_status_t vector_sorted_erase(void *vector, const void *key, int (*cmp)(const void *, const void *))
+{
+    if (!vector || !key || !cmp)
+    {
+        VECTOR_DEBUG_PERROR("Vector Sorted Erase: given null argument.\n");
+        return VEC_ERR;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    size_t i = vector_lower_bound(vector, key, cmp);
+    byte_t *item = (byte_t *)vector + i * hdr->tsize;
+    if (i == hdr->len || cmp(item, key) != 0)
+        return VEC_INDEX_OOB;
+    if (VECTOR_IS_SHARED(hdr))
+    {
+        VECTOR_DEBUG_PERROR("Vector Sorted Erase: vector is shared, call vector_unique first.\n");
+        return VEC_SHARED;
+    }
+    internal_vector_destroy_range(hdr->type, item, 1, hdr->tsize);
+    internal_vector_move_range(hdr->type, item, item + hdr->tsize, hdr->len - i - 1, hdr->tsize);
+    hdr->len--;
+    return VEC_OK;
+}
+
+vector_status_t vector_sorted_build(void *vector, int (*cmp)(const void *, const void *))
+{
+    if (!vector || !cmp)
+    {
+        VECTOR_DEBUG_PERROR("Vector Sorted Build: given null argument.\n");
+        return VEC_ERR;
+    }
+    if (VECTOR_IS_SHARED(VECTOR_HEADER(vector)))
+    {
+        VECTOR_DEBUG_PERROR("Vector Sorted Build: vector is shared, call vector_unique first.\n");
+        return VEC_SHARED;
+    }
+    if (vector_parallel_sort(vector, cmp) != VEC_OK)
+        return VEC_ERR;
+
+    /* Compact runs of equal elements down to their first */
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    size_t ts = hdr->tsize, i, out = 0;
+    byte_t *v = vector;
+    for (i = 1; i < hdr->len; i++)
+    {
+        if (cmp(v + out * ts, v + i * ts) == 0)
+        {
+            internal_vector_destroy_range(hdr->type, v + i * ts, 1, ts);
+            continue;
+        }
+        if (++out != i)
+            internal_vector_move_range(hdr->type, v + out * ts, v + i * ts, 1, ts);
+    }
+    if (hdr->len)
+        hdr->len = out + 1;
+    return VEC_OK;
+}
+
+void *internal_vector_sorted_insert(void *vector, const void *item, int (*cmp)(const void *, const void *))
+{
+    if (!vector || !item || !cmp)
+    {
+        VECTOR_DEBUG_PERROR("Vector Sorted Insert: given null argument.\n");
+        return NULL;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    size_t ts = hdr->tsize, len = hdr->len;
+    size_t i = vector_lower_bound(vector, item, cmp);
+    if (i < len && cmp((byte_t *)vector + i * ts, item) == 0)
+    {
+        vector = vector_make_unique(vector);
+        if (!vector)
+            return NULL;
+        memcpy((byte_t *)vector + i * ts, item, ts);
+        return vector;
+    }
+    /* Unshares, grows and opens the gap at i */
+    vector = internal_vector_prepare_insert(vector, ts, i);
+    if (!vector)
+        return NULL;
+    memcpy((byte_t *)vector + i * ts, item, ts);
+    internal_vector_set_len(vector, len + 1);
+    return vector;
+}
+
+/* In-order walk of the implicit tree, returns the next source index */
+static size_t vector_eytzinger_fill(byte_t *dst, const byte_t *src, size_t ts, size_t i, size_t k, size_t n)
+{
+    if (k > n)
+        return i;
+    i = vector_eytzinger_fill(dst, src, ts, i, 2 * k, n);
+    memcpy(dst + k * ts, src + i * ts, ts);
+    return vector_eytzinger_fill(dst, src, ts, i + 1, 2 * k + 1, n);
+}
+
+void *vector_eytzinger_build(const void *vector)
+{
+    if (!vector)
+    {
+        VECTOR_DEBUG_PERROR("Vector Eytzinger Build: given null vector.\n");
+        return NULL;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(vector);
+    size_t n = hdr->len, ts = hdr->tsize;
+    byte_t *eytz = vector_init_aligned(ts, n + 1, VECTOR_CACHE_LINE, hdr->a);
+    if (!eytz)
+        return NULL;
+    memset(eytz, 0, ts);
+    vector_eytzinger_fill(eytz, vector, ts, 0, 1, n);
+    internal_vector_set_len(eytz, n + 1);
+    return eytz;
+}
+
+size_t vector_eytzinger_lower_bound(const void *eytz, const void *key, int (*cmp)(const void *, const void *))
+{
+    if (!eytz || !key || !cmp)
+    {
+        VECTOR_DEBUG_PERROR("Vector Eytzinger Lower Bound: given null argument.\n");
+        return 0;
+    }
+    vector_header_t *hdr = VECTOR_HEADER(eytz);
+    size_t n = hdr->len ? hdr->len - 1 : 0, ts = hdr->tsize, k = 1;
+    size_t ahead = (ts < VECTOR_CACHE_LINE ? VECTOR_CACHE_LINE / ts : 1) * ts;
+    const byte_t *b = eytz;
+    while (k <= n)
+    {
+        VECTOR_SORTED_PREFETCH(b + k * ahead);
+        k = 2 * k + (cmp(b + k * ts, key) < 0);
+    }
+    return internal_vector_eytzinger_rank(k, n);
+}
+
+/*
+ * Map the node where a search fell off the tree back to a sorted index.
+ * Every right turn appends a one to k, so dropping the trailing ones and the
+ * last left turn leaves the answer node, 0 when every element was less.
+ * Its in-order position in the perfect tree of the same height is found
+ * from its depth and level offset, minus the missing leaves before it.
+ */
+size_t internal_vector_eytzinger_rank(size_t k, size_t n)
+{
+    k >>= vector_sorted_ctz(~k) + 1;
+    if (k == 0)
+        return n;
+    size_t depth = vector_sorted_log2(k), height = vector_sorted_log2(n);
+    size_t pos = ((2 * (k - ((size_t)1 << depth)) + 1) << (height - depth)) - 1;
+    size_t leaves = n - ((size_t)1 << height) + 1;
+    size_t before = (pos + 1) / 2;
+    return before > leaves ? pos - (before - leaves) : pos;
+}
@@ -0,0 +1,161 @@
+#ifndef _VECTOR_SORTED_H
+#define _VECTOR_SORTED_H
+
+#include "vector.h"
+
+/*
+ * Sorted vectors are regular vailed vectors kept in ascending order of a
+ * qsort-style comparator with no two elements comparing equal. They work as
+ * a set, or as a map when the comparator only looks at a key member.
+ */
+
+#if defined(__GNUC__)
+#define VECTOR_SORTED_PREFETCH(p) __builtin_prefetch(p)
+#define VECTOR_SORTED_FN static __attribute__((unused))
+#else
+#define VECTOR_SORTED_PREFETCH(p) ((void)0)
+#define VECTOR_SORTED_FN static
+#endif
+
+/* Elements of type T per cache line, how far an Eytzinger search prefetches */
+#define VECTOR_SORTED_LANES(T) (sizeof(T) < 64 ? 64 / sizeof(T) : 1)
+
+/**
+ * @brief Index of the first element not less than key.
+ *
+ * Branchless binary search: the loop always runs log2(len) times and picks the
+ * next half with a conditional move, prefetching both possible next probes.
+ *
+ * @param vector Sorted vector pointer.
+ * @param key Pointer to a value comparable with the elements.
+ * @param cmp qsort-style comparator, called as cmp(element, key).
+ * @return Index in [0, len], 0 on error.
+ */
+size_t vector_lower_bound(const void *vector, const void *key, int (*cmp)(const void *, const void *));
+
+/**
+ * @brief Pointer to the element equal to key.
+ *
+ * @param vector Sorted vector pointer.
+ * @param key Pointer to a value comparable with the elements.
+ * @param cmp qsort-style comparator.
+ * @return Pointer to the element, NULL if absent or on error.
+ */
+void *vector_sorted_find(const void *vector, const void *key, int (*cmp)(const void *, const void *));
+
+/**
+ * @brief Remove the element equal to key, keeping the order. O(n).
+ *
+ * @param vector Sorted vector pointer.
+ * @param key Pointer to a value comparable with the elements.
+ * @param cmp qsort-style comparator.
+ * @return VEC_OK on success, VEC_INDEX_OOB if key is absent, VEC_SHARED if the vector is shared, VEC_ERR on error
+ */
+vector_status_t vector_sorted_erase(void *vector, const void *key, int (*cmp)(const void *, const void *));
+
+/**
+ * @brief Sort a vector and drop duplicates, keeping the first of each run. O(n log n).
+ *
+ * Sorts with vector_parallel_sort(), so large inputs use every core.
+ *
+ * @param vector Vector pointer.
+ * @param cmp qsort-style comparator.
+ * @return VEC_OK on success, VEC_SHARED if the vector is shared, VEC_ERR on error
+ */
+vector_status_t vector_sorted_build(void *vector, int (*cmp)(const void *, const void *));
+
+/**
+ * @brief Insert a copy of *item at its sorted position. O(n).
+ *
+ * An element comparing equal is overwritten instead, so maps get
+ * insert-or-assign semantics. Automatically resizes if necessary.
+ *
+ * @param v Vector pointer (may be reassigned).
+ * @param item Pointer to the item to copy in.
+ * @param cmp qsort-style comparator.
+ */
+#define vector_sorted_insert(v, item, cmp)                              \
+    do                                                                  \
+    {                                                                   \
+        void *_tmp = internal_vector_sorted_insert((v), (item), (cmp)); \
+        if (_tmp)                                                       \
+            (v) = _tmp; /* Resize if needed */                          \
+    } while (0)
+
+/**
+ * @brief Copy a sorted vector into Eytzinger (breadth-first) order.
+ *
+ * Element k has its children at 2k and 2k + 1, so a search walks down the
+ * array and the next few levels of the tree share a cache line it can
+ * prefetch. Slot 0 is padding: the copy holds len + 1 elements and starts on
+ * a cache line. It is a read-only index, rebuild it after changing the source.
+ *
+ * @param vector Sorted vector pointer. Its allocator is used.
+ * @return void* The new vector on success, NULL on failure.
+ */
+void *vector_eytzinger_build(const void *vector);
+
+/**
+ * @brief vector_lower_bound() over an Eytzinger copy.
+ *
+ * Prefetches the cache line holding the descendants several levels below the
+ * current node, so the misses of consecutive levels overlap.
+ *
+ * @param eytz Vector from vector_eytzinger_build().
+ * @param key Pointer to a value comparable with the elements.
+ * @param cmp qsort-style comparator, called as cmp(element, key).
+ * @return Index of the first element not less than key in the original sorted vector, in [0, len], 0 on error.
+ */
+size_t vector_eytzinger_lower_bound(const void *eytz, const void *key, int (*cmp)(const void *, const void *));
+
+/**
+ * @brief Generate a typed branchless lower bound for sorted vectors of T.
+ *
+ * Defines static size_t vector_lower_bound_<name>(const T *v, T key) and
+ * vector_eytzinger_lower_bound_<name>(const T *eytz, T key), the same searches
+ * as vector_lower_bound() and vector_eytzinger_lower_bound() with the
+ * comparison inlined.
+ *
+ * @param name Suffix for the generated function.
+ * @param T Element type.
+ * @param LESS Function-like macro or function, LESS(a, b) is nonzero when a sorts before b.
+ */
+#define VECTOR_SORTED_DEFINE(name, T, LESS)                              \
+    VECTOR_SORTED_FN size_t vector_lower_bound_##name(const T *v, T key) \
+    {                                                                    \
+        size_t n;                                                        \
+        if (vector_get_len((void *)v, &n) != VEC_OK || n == 0)           \
+            return 0;                                                    \
+        const T *base = v;                                               \
+        while (n > 1)                                                    \
+        {                                                                \
+            size_t half = n / 2;                                         \
+            VECTOR_SORTED_PREFETCH(base + half / 2);                     \
+            VECTOR_SORTED_PREFETCH(base + half + half / 2);              \
+            base = LESS(base[half], key) ? base + half : base;           \
+            n -= half;                                                   \
+        }                                                                \
+        return (size_t)(base - v) + (LESS(*base, key) ? 1 : 0);          \
+    }                                                                    \
+                                                                         \
+    VECTOR_SORTED_FN size_t vector_eytzinger_lower_bound_##name(         \
+        const T *eytz, T key)                                            \
+    {                                                                    \
+        size_t n, k = 1;                                                 \
+        if (vector_get_len((void *)eytz, &n) != VEC_OK || n == 0)        \
+            return 0;                                                    \
+        n--; /* slot 0 is padding */                                     \
+        while (k <= n)                                                   \
+        {                                                                \
+            VECTOR_SORTED_PREFETCH(eytz + k * VECTOR_SORTED_LANES(T));   \
+            k = 2 * k + (LESS(eytz[k], key) ? 1 : 0);                    \
+        }                                                                \
+        return internal_vector_eytzinger_rank(k, n);                     \
+    }
+
+/* Internal methdods */
+
+void *internal_vector_sorted_insert(void *vector, const void *item, int (*cmp)(const void *, const void *));
+size_t internal_vector_eytzinger_rank(size_t k, size_t n);
+
+#endif /* _VECTOR_SORTED_H */
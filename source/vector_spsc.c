@@ -0,0 +1,159 @@
+#include "vector_spsc.h"
+#include "vector_internal.h"
+#include <stdatomic.h>
+#include <string.h>
+
+/* Consumer fields, producer fields and the read-only vector header each start
+ * their own cache line so the two threads only share the index they publish. */
+typedef struct
+{
+    atomic_size_t head; /* next index to read, written by consumer */
+    size_t tail_cache;  /* consumer's last observed tail */
+    byte_t pad0[VECTOR_CACHE_LINE - sizeof(atomic_size_t) - sizeof(size_t)];
+
+    atomic_size_t tail; /* next index to write, written by producer */
+    size_t head_cache;  /* producer's last observed head */
+    byte_t pad1[VECTOR_CACHE_LINE - sizeof(atomic_size_t) - sizeof(size_t)];
+
+    vector_header_t vec; /* cap (power of two), tsize, allocator; len unused */
+} vector_spsc_header_t;
+
+#define VECTOR_SPSC_HEADER(queue) ((vector_spsc_header_t *)((byte_t *)queue - sizeof(vector_spsc_header_t)))
+
+/* Copy n items between the ring (starting at index) and a flat buffer, handling wrap */
+static void vector_spsc_copy(vector_spsc_header_t *hdr, byte_t *ring, size_t index, byte_t *flat, size_t n, int to_ring)
+{
+    size_t tsize = hdr->vec.tsize;
+    size_t slot = index & (hdr->vec.cap - 1);
+    size_t first = hdr->vec.cap - slot;
+    if (first > n)
+        first = n;
+    if (to_ring)
+    {
+        memcpy(ring + slot * tsize, flat, first * tsize);
+        memcpy(ring, flat + first * tsize, (n - first) * tsize);
+    }
+    else
+    {
+        memcpy(flat, ring + slot * tsize, first * tsize);
+        memcpy(flat + first * tsize, ring, (n - first) * tsize);
+    }
+}
+
+/* Initialize a new queue */
+void *vector_spsc_init(size_t tsize, size_t cap, allocator_t *a)
+{
+    if (!a)
+    {
+        VECTOR_DEBUG_PERROR("Vector SPSC Init: given null allocator.\n");
+        return NULL;
+    }
+    size_t slots = 1;
+    while (slots < cap)
+        slots <<= 1;
+
+    vector_spsc_header_t *hdr = a->malloc(sizeof(vector_spsc_header_t) + tsize * slots);
+    if (!hdr)
+    {
+        VECTOR_DEBUG_PERROR("Vector SPSC Init: allocation failed.\n");
+        return NULL;
+    }
+    atomic_init(&hdr->head, 0);
+    atomic_init(&hdr->tail, 0);
+    hdr->tail_cache = 0;
+    hdr->head_cache = 0;
+    internal_vector_header_init(&hdr->vec, tsize, slots, a);
+    return (byte_t *)hdr + sizeof(vector_spsc_header_t);
+}
+
+/* Free a queue */
+vector_status_t vector_spsc_free(void *queue)
+{
+    if (!queue)
+    {
+        VECTOR_DEBUG_PERROR("Vector SPSC Free: given null queue.\n");
+        return VEC_ERR;
+    }
+    vector_spsc_header_t *hdr = VECTOR_SPSC_HEADER(queue);
+    if (!hdr->vec.a)
+    {
+        VECTOR_DEBUG_PERROR("Vector SPSC Free: null allocator in header.\n");
+        return VEC_ERR;
+    }
+    hdr->vec.a->free(hdr);
+    return VEC_OK;
+}
+
+vector_status_t vector_spsc_push(void *queue, const void *item)
+{
+    return vector_spsc_push_many(queue, item, 1) == 1 ? VEC_OK : (queue && item ? VEC_FULL : VEC_ERR);
+}
+
+vector_status_t vector_spsc_pop(void *queue, void *out)
+{
+    return vector_spsc_pop_many(queue, out, 1) == 1 ? VEC_OK : (queue && out ? VEC_EMPTY : VEC_ERR);
+}
+
+size_t vector_spsc_push_many(void *queue, const void *items, size_t n)
+{
+    if (!queue || !items)
+    {
+        VECTOR_DEBUG_PERROR("Vector SPSC Push: given null queue or items.\n");
+        return 0;
+    }
+    vector_spsc_header_t *hdr = VECTOR_SPSC_HEADER(queue);
+    size_t tail = atomic_load_explicit(&hdr->tail, memory_order_relaxed);
+    size_t room = hdr->vec.cap - (tail - hdr->head_cache);
+    if (room < n)
+    {
+        /* Only touch the consumer's line when the cached view is not enough */
+        hdr->head_cache = atomic_load_explicit(&hdr->head, memory_order_acquire);
+        room = hdr->vec.cap - (tail - hdr->head_cache);
+    }
+    if (n > room)
+        n = room;
+    if (n == 0)
+        return 0;
+
+    vector_spsc_copy(hdr, queue, tail, (byte_t *)items, n, 1);
+    atomic_store_explicit(&hdr->tail, tail + n, memory_order_release);
+    return n;
+}
+
+size_t vector_spsc_pop_many(void *queue, void *out, size_t n)
+{
+    if (!queue || !out)
+    {
+        VECTOR_DEBUG_PERROR("Vector SPSC Pop: given null queue or out.\n");
+        return 0;
+    }
+    vector_spsc_header_t *hdr = VECTOR_SPSC_HEADER(queue);
+    size_t head = atomic_load_explicit(&hdr->head, memory_order_relaxed);
+    size_t avail = hdr->tail_cache - head;
+    if (avail < n)
+    {
+        hdr->tail_cache = atomic_load_explicit(&hdr->tail, memory_order_acquire);
+        avail = hdr->tail_cache - head;
+    }
+    if (n > avail)
+        n = avail;
+    if (n == 0)
+        return 0;
+
+    vector_spsc_copy(hdr, queue, head, out, n, 0);
+    atomic_store_explicit(&hdr->head, head + n, memory_order_release);
+    return n;
+}
+
+size_t vector_spsc_size(void *queue)
+{
+    if (!queue)
+    {
+        VECTOR_DEBUG_PERROR("Vector SPSC Size: given null queue.\n");
+        return 0;
+    }
+    vector_spsc_header_t *hdr = VECTOR_SPSC_HEADER(queue);
+    size_t head = atomic_load_explicit(&hdr->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&hdr->tail, memory_order_acquire);
+    return tail - head;
+}
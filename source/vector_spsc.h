@@ -0,0 +1,87 @@
+#ifndef _VECTOR_SPSC_H
+#define _VECTOR_SPSC_H
+
+#include "vector.h"
+
+/**
+ * @brief Create a bounded single-producer/single-consumer queue of type T.
+ *
+ * The queue is a vailed ring: the returned pointer addresses a power-of-two
+ * slot array and the header (with head and tail indices on separate cache
+ * lines) lives in front of it. Exactly one thread may push and exactly one
+ * thread may pop concurrently; no locks are taken.
+ *
+ * @param T Type of the elements.
+ * @param cap Minimum capacity, rounded up to a power of two.
+ * @param a Pointer to allocator_t.
+ * @return T* Pointer to the slot array.
+ */
+#define vector_spsc(T, cap, a) (T *)vector_spsc_init(sizeof(T), cap, a)
+
+/**
+ * @brief Initialize a SPSC queue.
+ *
+ * @param tsize Size of each element (sizeof(T)).
+ * @param cap Minimum capacity, rounded up to a power of two.
+ * @param a Pointer to allocator_t.
+ * @return void* Pointer to slot array on success, NULL on failure.
+ */
+void *vector_spsc_init(size_t tsize, size_t cap, allocator_t *a);
+
+/**
+ * @brief Free a SPSC queue. No thread may be using it.
+ *
+ * @param queue Queue pointer.
+ * @return VEC_OK on success, VEC_ERR on error
+ */
+vector_status_t vector_spsc_free(void *queue);
+
+/**
+ * @brief Copy one item into the queue. Producer thread only.
+ *
+ * @param queue Queue pointer.
+ * @param item Pointer to the item to copy in.
+ * @return VEC_OK on success, VEC_FULL if no slot is free, VEC_ERR on error
+ */
+vector_status_t vector_spsc_push(void *queue, const void *item);
+
+/**
+ * @brief Copy one item out of the queue. Consumer thread only.
+ *
+ * @param queue Queue pointer.
+ * @param out Reference to copy the item to.
+ * @return VEC_OK on success, VEC_EMPTY if nothing is queued, VEC_ERR on error
+ */
+vector_status_t vector_spsc_pop(void *queue, void *out);
+
+/**
+ * @brief Copy up to n contiguous items into the queue with a single publish. Producer thread only.
+ *
+ * @param queue Queue pointer.
+ * @param items Source array.
+ * @param n Number of items in source.
+ * @return Number of items actually pushed (0 when full or on error).
+ */
+size_t vector_spsc_push_many(void *queue, const void *items, size_t n);
+
+/**
+ * @brief Copy up to n items out of the queue with a single release. Consumer thread only.
+ *
+ * @param queue Queue pointer.
+ * @param out Destination array with room for n items.
+ * @param n Maximum number of items to pop.
+ * @return Number of items actually popped (0 when empty or on error).
+ */
+size_t vector_spsc_pop_many(void *queue, void *out, size_t n);
+
+/**
+ * @brief Number of queued items. Exact only when neither side is active.
+ *
+ * vector_get_cap() reports the slot count of the queue; vector_get_len() does not track it.
+ *
+ * @param queue Queue pointer.
+ * @return Number of queued items, 0 on error.
+ */
+size_t vector_spsc_size(void *queue);
+
+#endif /* _VECTOR_SPSC_H */
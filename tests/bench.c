@@ -0,0 +1,1232 @@
+#define _GNU_SOURCE /* for pthread_setaffinity_np */
+#include "../source/vector.h"
+#include "../source/vector_spsc.h"
+#include "../source/vector_mpmc.h"
+#include "../source/vector_parallel.h"
+#include "../source/vector_scheduler.h"
+#include "../source/vector_sort.h"
+#include "../source/vector_soa.h"
+#include "../source/vector_bits.h"
+#include "../source/vector_sorted.h"
+#include "../source/vector_hash.h"
+#include "../source/vector_heap.h"
+#include "../source/vector_pool.h"
+#include "../source/vector_compact.h"
+#include "../source/vector_csr.h"
+#include "../source/vector_pipeline.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*  -------- Helpers ---------- */
+
+static allocator_t a = {malloc, realloc, free};
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void pin_self(int cpu)
+{
+    cpu_set_t set;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    CPU_ZERO(&set);
+    CPU_SET(cpu % (ncpu > 0 ? ncpu : 1), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/*  -------- SPSC queue ---------- */
+
+#define SPSC_ITEMS 20000000
+#define SPSC_PINGS 1000000
+#define SPSC_BATCH 64
+
+typedef struct
+{
+    size_t *q;
+    size_t *back; /* reply queue for the ping-pong run */
+    size_t batch;
+} spsc_args_t;
+
+static void *spsc_consumer(void *arg)
+{
+    spsc_args_t *s = arg;
+    size_t buf[SPSC_BATCH];
+    size_t got = 0, sum = 0;
+    pin_self(1);
+    while (got < SPSC_ITEMS)
+    {
+        size_t n = s->batch > 1 ? vector_spsc_pop_many(s->q, buf, s->batch)
+                                : (vector_spsc_pop(s->q, buf) == VEC_OK);
+        size_t i;
+        if (n == 0)
+            sched_yield(); /* keeps oversubscribed machines moving */
+        for (i = 0; i < n; i++)
+            sum += buf[i];
+        got += n;
+    }
+    return (void *)sum;
+}
+
+static void *spsc_echo(void *arg)
+{
+    spsc_args_t *s = arg;
+    size_t i, v;
+    pin_self(1);
+    for (i = 0; i < SPSC_PINGS; i++)
+    {
+        while (vector_spsc_pop(s->q, &v) != VEC_OK)
+            sched_yield();
+        while (vector_spsc_push(s->back, &v) != VEC_OK)
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void bench_spsc(void)
+{
+    size_t batch;
+    printf("SPSC queue, 2 pinned threads\n");
+    for (batch = 1; batch <= SPSC_BATCH; batch *= SPSC_BATCH)
+    {
+        spsc_args_t s = {vector_spsc(size_t, 4096, &a), NULL, batch};
+        size_t buf[SPSC_BATCH];
+        size_t i = 0, j;
+        pthread_t t;
+        pin_self(0);
+        double t0 = now_sec();
+        pthread_create(&t, NULL, spsc_consumer, &s);
+        while (i < SPSC_ITEMS)
+        {
+            size_t want = batch;
+            if (want > SPSC_ITEMS - i)
+                want = SPSC_ITEMS - i;
+            for (j = 0; j < want; j++)
+                buf[j] = i + j;
+            size_t n = batch > 1 ? vector_spsc_push_many(s.q, buf, want) : (vector_spsc_push(s.q, buf) == VEC_OK);
+            if (n == 0)
+                sched_yield();
+            i += n;
+        }
+        pthread_join(t, NULL);
+        double dt = now_sec() - t0;
+        printf("  throughput batch %-3zu: %8.1f Mitems/s\n", batch, SPSC_ITEMS / dt / 1e6);
+        vector_spsc_free(s.q);
+    }
+
+    {
+        spsc_args_t s = {vector_spsc(size_t, 64, &a), vector_spsc(size_t, 64, &a), 1};
+        size_t i, v;
+        pthread_t t;
+        pthread_create(&t, NULL, spsc_echo, &s);
+        double t0 = now_sec();
+        for (i = 0; i < SPSC_PINGS; i++)
+        {
+            vector_spsc_push(s.q, &i);
+            while (vector_spsc_pop(s.back, &v) != VEC_OK)
+                sched_yield();
+        }
+        double dt = now_sec() - t0;
+        pthread_join(t, NULL);
+        printf("  round-trip latency    : %8.1f ns\n", dt / SPSC_PINGS * 1e9);
+        vector_spsc_free(s.q);
+        vector_spsc_free(s.back);
+    }
+}
+
+/*  -------- MPMC queue ---------- */
+
+#define MPMC_OPS 2000000 /* push+pop pairs, split across threads */
+
+typedef struct
+{
+    size_t *q;
+    size_t ops;
+    size_t batch;
+    pthread_barrier_t *start;
+} mpmc_args_t;
+
+static void *mpmc_worker(void *arg)
+{
+    mpmc_args_t *m = arg;
+    size_t buf[16];
+    size_t done = 0;
+    pthread_barrier_wait(m->start);
+    while (done < m->ops)
+    {
+        size_t want = m->batch, n, got = 0;
+        if (want > m->ops - done)
+            want = m->ops - done;
+        while ((n = vector_mpmc_push_many(m->q, buf, want)) == 0)
+            sched_yield();
+        while (got < n)
+        {
+            size_t k = vector_mpmc_pop_many(m->q, buf, n - got);
+            if (k == 0)
+                sched_yield();
+            got += k;
+        }
+        done += n;
+    }
+    return NULL;
+}
+
+static void bench_mpmc(void)
+{
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = ncpu > 2 ? (size_t)ncpu : 2;
+    size_t threads, batch, i;
+    printf("MPMC queue, every thread pushes then pops\n");
+    for (batch = 1; batch <= 16; batch *= 16)
+    {
+        for (threads = 1; threads <= max_threads; threads *= 2)
+        {
+            size_t *q = vector_mpmc(size_t, 1024, &a);
+            pthread_t t[64];
+            mpmc_args_t args[64];
+            pthread_barrier_t start;
+            if (threads > 64)
+                break;
+            pthread_barrier_init(&start, NULL, threads + 1);
+            for (i = 0; i < threads; i++)
+            {
+                mpmc_args_t m = {q, MPMC_OPS / threads, batch, &start};
+                args[i] = m;
+                pthread_create(&t[i], NULL, mpmc_worker, &args[i]);
+            }
+            double t0 = now_sec();
+            pthread_barrier_wait(&start);
+            for (i = 0; i < threads; i++)
+                pthread_join(t[i], NULL);
+            double dt = now_sec() - t0;
+            printf("  %2zu threads batch %-2zu: %8.1f Mops/s\n", threads, batch, 2.0 * MPMC_OPS / dt / 1e6);
+            pthread_barrier_destroy(&start);
+            vector_mpmc_free(q);
+        }
+    }
+}
+
+/*  -------- Parallel for / reduce ---------- */
+
+#define PARALLEL_LEN 20000000
+
+static void parallel_body(void *vector, size_t begin, size_t end, void *ctx)
+{
+    double *v = vector;
+    for (; begin < end; begin++)
+        v[begin] = sqrt(v[begin] * 3.0 + 1.0);
+}
+
+static void parallel_sum(const void *in, size_t begin, size_t end, void *partial, void *ctx)
+{
+    double s = 0;
+    for (; begin < end; begin++)
+        s += ((const double *)in)[begin];
+    *(double *)partial += s;
+}
+
+static void parallel_combine(void *acc, const void *partial, void *ctx)
+{
+    *(double *)acc += *(const double *)partial;
+}
+
+static void bench_parallel(void)
+{
+    double *v = (double *)vector_init(sizeof(double), PARALLEL_LEN, &a);
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads, i;
+    for (i = 0; i < PARALLEL_LEN; i++)
+        vector_push_back(v, (double)i);
+    printf("Parallel for / reduce over %d doubles\n", PARALLEL_LEN);
+    for (threads = 1; threads <= (size_t)(ncpu > 1 ? ncpu : 1); threads *= 2)
+    {
+        double sum = 0, det = 0;
+        vector_parallel_set_threads(threads);
+        double t0 = now_sec();
+        vector_parallel_for(v, parallel_body, NULL, 0);
+        double t1 = now_sec();
+        vector_parallel_reduce(v, &sum, sizeof(sum), parallel_sum, parallel_combine, NULL, 0, 0);
+        double t2 = now_sec();
+        vector_parallel_reduce(v, &det, sizeof(det), parallel_sum, parallel_combine, NULL, 0, VECTOR_PARALLEL_DETERMINISTIC);
+        double t3 = now_sec();
+        printf("  %2zu threads: for %7.1f ms, reduce %6.1f ms, deterministic reduce %6.1f ms\n",
+               threads, (t1 - t0) * 1e3, (t2 - t1) * 1e3, (t3 - t2) * 1e3);
+    }
+    vector_parallel_set_threads(0);
+    vector_free(v);
+}
+
+/*  -------- Work stealing, unbalanced ---------- */
+
+#define UNBALANCED_LEN 20000
+
+/* Element i costs O(i) work, so equal index ranges carry very unequal load */
+static void unbalanced_body(void *vector, size_t begin, size_t end, void *ctx)
+{
+    double *v = vector;
+    for (; begin < end; begin++)
+    {
+        double x = v[begin];
+        size_t k;
+        for (k = 0; k < begin; k++)
+            x = x * 0.999 + 1.0;
+        v[begin] = x;
+    }
+}
+
+static void bench_scheduler(void)
+{
+    double *v = vector(double, &a);
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = ncpu > 1 ? (size_t)ncpu : 1;
+    size_t i;
+    for (i = 0; i < UNBALANCED_LEN; i++)
+        vector_push_back(v, 0.0);
+    printf("Unbalanced loop, %zu threads\n", threads);
+
+    vector_parallel_set_threads(threads);
+    double t0 = now_sec();
+    vector_parallel_for(v, unbalanced_body, NULL, UNBALANCED_LEN / threads + 1); /* one static block each */
+    double t1 = now_sec();
+    printf("  static blocks      : %7.1f ms\n", (t1 - t0) * 1e3);
+    vector_parallel_set_threads(0);
+
+    vector_scheduler_t *s = vector_scheduler_create(threads, &a);
+    t0 = now_sec();
+    vector_scheduler_for(s, v, unbalanced_body, NULL, 0);
+    t1 = now_sec();
+    printf("  work stealing split: %7.1f ms\n", (t1 - t0) * 1e3);
+    vector_scheduler_destroy(s);
+    vector_free(v);
+}
+
+/*  -------- Parallel Sort -------- */
+
+#define SORT_LEN 20000000
+
+#define INT_LESS(x, y) ((x) < (y))
+VECTOR_SORT_DEFINE(int, int, INT_LESS)
+
+static int int_cmp(const void *x, const void *y)
+{
+    int l = *(const int *)x, r = *(const int *)y;
+    return (l > r) - (l < r);
+}
+
+static void sort_fill(int *v, int *src)
+{
+    memcpy(v, src, SORT_LEN * sizeof(int));
+}
+
+static void bench_sort(void)
+{
+    int *src = vector(int, &a), *v = vector(int, &a);
+    unsigned x = 2463534242u;
+    size_t i;
+    for (i = 0; i < SORT_LEN; i++)
+    {
+        x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+        vector_push_back(src, (int)x);
+        vector_push_back(v, 0);
+    }
+    printf("Sorting %d ints, %zu scheduler threads\n", SORT_LEN, vector_scheduler_threads(vector_scheduler_default()));
+
+    sort_fill(v, src);
+    double t0 = now_sec();
+    qsort(v, SORT_LEN, sizeof(int), int_cmp);
+    double t1 = now_sec();
+    printf("  qsort               : %7.1f ms\n", (t1 - t0) * 1e3);
+
+    sort_fill(v, src);
+    t0 = now_sec();
+    vector_sort_int(v);
+    t1 = now_sec();
+    printf("  typed sequential    : %7.1f ms\n", (t1 - t0) * 1e3);
+
+    sort_fill(v, src);
+    t0 = now_sec();
+    vector_parallel_sort(v, int_cmp);
+    t1 = now_sec();
+    printf("  generic parallel    : %7.1f ms\n", (t1 - t0) * 1e3);
+
+    sort_fill(v, src);
+    t0 = now_sec();
+    vector_parallel_sort_int(v);
+    t1 = now_sec();
+    printf("  typed parallel      : %7.1f ms\n", (t1 - t0) * 1e3);
+
+    for (i = 1; i < SORT_LEN; i++)
+        if (v[i - 1] > v[i])
+        {
+            printf("  not sorted at %zu\n", i);
+            break;
+        }
+    vector_free(src);
+    vector_free(v);
+}
+
+/*  -------- Struct of Arrays -------- */
+
+#define SOA_LEN 10000000
+#define SOA_REPS 10
+
+typedef struct
+{
+    uint64_t id;
+    float x, y, z;
+    uint8_t flags;
+} particle_t;
+
+#define PARTICLE_FIELDS(X) X(uint64_t, id) X(float, x) X(float, y) X(float, z) X(uint8_t, flags)
+VECTOR_SOA_DEFINE(particle, particle_t, PARTICLE_FIELDS)
+
+static void bench_soa(void)
+{
+    particle_t *aos = vector(particle_t, &a);
+    particle_t p = {0, 1.0f, 2.0f, 3.0f, 0};
+    size_t i, r;
+    for (i = 0; i < SOA_LEN; i++)
+    {
+        p.id = i;
+        vector_push_back(aos, p);
+    }
+    vector_soa_particle_t soa;
+    vector_soa_particle_init(&soa, 0, &a);
+    vector_soa_particle_from_aos(&soa, aos);
+    printf("Sum of one float field, %d records of %zu bytes, %d passes\n", SOA_LEN, sizeof(particle_t), SOA_REPS);
+
+    float sum = 0.0f;
+    double t0 = now_sec();
+    for (r = 0; r < SOA_REPS; r++)
+        for (i = 0; i < SOA_LEN; i++)
+            sum += aos[i].x;
+    double t1 = now_sec();
+    printf("  array of structs: %7.1f ms (%g)\n", (t1 - t0) * 1e3, sum);
+
+    sum = 0.0f;
+    t0 = now_sec();
+    for (r = 0; r < SOA_REPS; r++)
+        for (i = 0; i < soa.len; i++)
+            sum += soa.x[i];
+    t1 = now_sec();
+    printf("  struct of arrays: %7.1f ms (%g)\n", (t1 - t0) * 1e3, sum);
+
+    vector_soa_particle_free(&soa);
+    vector_free(aos);
+}
+
+/*  -------- Bit Vectors -------- */
+
+#define BITS_LEN ((size_t)1 << 26)
+#define BITS_REPS 20
+
+static void bench_bits(void)
+{
+    uint64_t *x = vector_bits_init(BITS_LEN, &a), *y = vector_bits_init(BITS_LEN, &a);
+    uint8_t *fx = vector(uint8_t, &a), *fy = vector(uint8_t, &a);
+    size_t i, r, count = 0;
+    unsigned s = 1;
+    x = vector_bits_resize(x, BITS_LEN);
+    y = vector_bits_resize(y, BITS_LEN);
+    for (i = 0; i < BITS_LEN; i++)
+    {
+        s = s * 1103515245u + 12345u;
+        vector_push_back(fx, (uint8_t)((s >> 16) & 1));
+        vector_push_back(fy, (uint8_t)((s >> 17) & 1));
+        if (fx[i])
+            vector_bits_set(x, i);
+        if (fy[i])
+            vector_bits_set(y, i);
+    }
+    printf("AND then count of %zu flags, %d passes\n", BITS_LEN, BITS_REPS);
+
+    double t0 = now_sec();
+    for (r = 0; r < BITS_REPS; r++)
+    {
+        count = 0;
+        for (i = 0; i < BITS_LEN; i++)
+        {
+            fx[i] &= fy[i];
+            count += fx[i];
+        }
+    }
+    double t1 = now_sec();
+    printf("  uint8_t flags: %7.1f ms (%zu set, %zu MB each)\n", (t1 - t0) * 1e3, count, BITS_LEN >> 20);
+
+    t0 = now_sec();
+    for (r = 0; r < BITS_REPS; r++)
+    {
+        vector_bits_and(x, y);
+        count = vector_bits_count(x);
+    }
+    t1 = now_sec();
+    printf("  bit vector   : %7.1f ms (%zu set, %zu MB each)\n", (t1 - t0) * 1e3, count, BITS_LEN >> 23);
+
+    vector_free(x);
+    vector_free(y);
+    vector_free(fx);
+    vector_free(fy);
+}
+
+#define RANK_BITS ((size_t)1 << 30)
+#define RANK_QUERIES 10000000
+
+static void bench_rank(void)
+{
+    uint64_t *bv = vector_bits_init(RANK_BITS, &a);
+    uint64_t x = 88172645463325252ULL;
+    size_t i, sum = 0;
+    bv = vector_bits_resize(bv, RANK_BITS);
+    if (!bv)
+        return;
+    for (i = 0; i < RANK_BITS / 64; i++)
+    {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        bv[i] = x;
+    }
+    double t0 = now_sec();
+    vector_bits_rank_t *r = vector_bits_rank_init(bv);
+    double t1 = now_sec();
+    size_t ones = vector_bits_rank(r, RANK_BITS);
+    printf("Rank/select over %zu bits, %zu ones\n", RANK_BITS, ones);
+    printf("  build : %7.1f ms, index %.2f%% of the bits\n", (t1 - t0) * 1e3,
+           100.0 * vector_bits_rank_bytes(r) / (RANK_BITS / 8));
+
+    t0 = now_sec();
+    for (i = 0; i < RANK_QUERIES; i++)
+    {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        sum += vector_bits_rank(r, x % RANK_BITS);
+    }
+    t1 = now_sec();
+    printf("  rank  : %7.1f Mq/s\n", RANK_QUERIES / (t1 - t0) / 1e6);
+
+    t0 = now_sec();
+    for (i = 0; i < RANK_QUERIES; i++)
+    {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        sum += vector_bits_select(r, x % ones);
+    }
+    t1 = now_sec();
+    printf("  select: %7.1f Mq/s (%zu)\n", RANK_QUERIES / (t1 - t0) / 1e6, sum);
+    vector_bits_rank_free(r);
+    vector_free(bv);
+}
+
+/*  -------- Sorted Lookup -------- */
+
+#define LOOKUPS 5000000
+
+#define U64_LESS(x, y) ((x) < (y))
+VECTOR_SORTED_DEFINE(u64, uint64_t, U64_LESS)
+
+static int u64_cmp(const void *x, const void *y)
+{
+    uint64_t l = *(const uint64_t *)x, r = *(const uint64_t *)y;
+    return (l > r) - (l < r);
+}
+
+static uint64_t xorshift64(uint64_t *s)
+{
+    *s ^= *s << 13, *s ^= *s >> 7, *s ^= *s << 17;
+    return *s;
+}
+
+/* Baseline: open addressing hash set, linear probing, load factor at most 1/2 */
+typedef struct
+{
+    uint64_t *slots; /* 0 marks an empty slot, keys are never 0 */
+    size_t mask;
+} bench_hash_t;
+
+static size_t bench_hash_slot(uint64_t k)
+{
+    return (size_t)((k * 0x9E3779B97F4A7C15ULL) >> 20);
+}
+
+static void bench_hash_init(bench_hash_t *h, const uint64_t *keys, size_t n)
+{
+    size_t cap = 16, i;
+    while (cap < 2 * n)
+        cap *= 2;
+    h->slots = calloc(cap, sizeof(uint64_t));
+    h->mask = cap - 1;
+    for (i = 0; i < n; i++)
+    {
+        size_t j = bench_hash_slot(keys[i]) & h->mask;
+        while (h->slots[j] && h->slots[j] != keys[i])
+            j = (j + 1) & h->mask;
+        h->slots[j] = keys[i];
+    }
+}
+
+static int bench_hash_find(const bench_hash_t *h, uint64_t k)
+{
+    size_t j = bench_hash_slot(k) & h->mask;
+    while (h->slots[j])
+    {
+        if (h->slots[j] == k)
+            return 1;
+        j = (j + 1) & h->mask;
+    }
+    return 0;
+}
+
+static void bench_sorted(void)
+{
+    size_t sizes[] = {1000, 100000, 10000000};
+    size_t z, i, n;
+    printf("Lookups of present keys, %d per size\n", LOOKUPS);
+    for (z = 0; z < sizeof(sizes) / sizeof(sizes[0]); z++)
+    {
+        uint64_t seed = 42, *keys = vector(uint64_t, &a);
+        for (i = 0; i < sizes[z]; i++)
+            vector_push_back(keys, xorshift64(&seed) | 1);
+        vector_sorted_build(keys, u64_cmp);
+        vector_get_len(keys, &n);
+        bench_hash_t h;
+        bench_hash_init(&h, keys, n);
+
+        /* Same pseudo-random key order for every structure */
+        size_t found = 0;
+        seed = 7;
+        double t0 = now_sec();
+        for (i = 0; i < LOOKUPS; i++)
+            found += bench_hash_find(&h, keys[xorshift64(&seed) % n]);
+        double t1 = now_sec();
+        printf("  %8zu keys: hash map %6.1f ns", n, (t1 - t0) * 1e9 / LOOKUPS);
+
+        seed = 7;
+        t0 = now_sec();
+        for (i = 0; i < LOOKUPS; i++)
+            found += vector_lower_bound(keys, &keys[xorshift64(&seed) % n], u64_cmp) < n;
+        t1 = now_sec();
+        printf(", lower_bound %6.1f ns", (t1 - t0) * 1e9 / LOOKUPS);
+
+        seed = 7;
+        t0 = now_sec();
+        for (i = 0; i < LOOKUPS; i++)
+            found += vector_lower_bound_u64(keys, keys[xorshift64(&seed) % n]) < n;
+        t1 = now_sec();
+        printf(", typed %6.1f ns (%zu)\n", (t1 - t0) * 1e9 / LOOKUPS, found);
+        free(h.slots);
+        vector_free(keys);
+    }
+}
+
+static void bench_eytzinger(void)
+{
+    size_t sizes[] = {1000, 100000, 10000000, 100000000};
+    size_t z, i, n;
+    printf("Lower bound of random keys, %d per size\n", LOOKUPS);
+    for (z = 0; z < sizeof(sizes) / sizeof(sizes[0]); z++)
+    {
+        uint64_t seed = 42, *keys = vector_init(sizeof(uint64_t), sizes[z], &a);
+        for (i = 0; i < sizes[z]; i++)
+            vector_push_back(keys, xorshift64(&seed));
+        vector_sorted_build(keys, u64_cmp);
+        vector_get_len(keys, &n);
+        uint64_t *eytz = vector_eytzinger_build(keys);
+
+        /* Checksums of the returned indices must agree */
+        size_t sum_sorted = 0, sum_eytz = 0;
+        seed = 7;
+        double t0 = now_sec();
+        for (i = 0; i < LOOKUPS; i++)
+            sum_sorted += vector_lower_bound_u64(keys, xorshift64(&seed));
+        double t1 = now_sec();
+        printf("  %9zu keys: lower_bound %6.1f ns", n, (t1 - t0) * 1e9 / LOOKUPS);
+
+        seed = 7;
+        t0 = now_sec();
+        for (i = 0; i < LOOKUPS; i++)
+            sum_eytz += vector_eytzinger_lower_bound_u64(eytz, xorshift64(&seed));
+        t1 = now_sec();
+        printf(", eytzinger %6.1f ns (%s)\n", (t1 - t0) * 1e9 / LOOKUPS,
+               sum_sorted == sum_eytz ? "match" : "MISMATCH");
+        vector_free(eytz);
+        vector_free(keys);
+    }
+}
+
+/* Baseline: separate chaining, one allocated node per key, fixed bucket count */
+typedef struct bench_chain_node_t
+{
+    uint64_t key;
+    uint64_t value;
+    struct bench_chain_node_t *next;
+} bench_chain_node_t;
+
+typedef struct
+{
+    bench_chain_node_t **buckets;
+    size_t mask;
+} bench_chain_t;
+
+static void bench_chain_insert(bench_chain_t *c, uint64_t k, uint64_t v)
+{
+    bench_chain_node_t **b = &c->buckets[vector_hash_u64(&k) & c->mask], *node;
+    for (node = *b; node; node = node->next)
+        if (node->key == k)
+        {
+            node->value = v;
+            return;
+        }
+    node = malloc(sizeof(*node));
+    node->key = k;
+    node->value = v;
+    node->next = *b;
+    *b = node;
+}
+
+static uint64_t *bench_chain_find(const bench_chain_t *c, uint64_t k)
+{
+    bench_chain_node_t *node = c->buckets[vector_hash_u64(&k) & c->mask];
+    for (; node; node = node->next)
+        if (node->key == k)
+            return &node->value;
+    return NULL;
+}
+
+static void bench_chain_free(bench_chain_t *c)
+{
+    size_t i;
+    for (i = 0; i <= c->mask; i++)
+        while (c->buckets[i])
+        {
+            bench_chain_node_t *next = c->buckets[i]->next;
+            free(c->buckets[i]);
+            c->buckets[i] = next;
+        }
+    free(c->buckets);
+}
+
+#define HASH_SLOTS ((size_t)1 << 22)
+
+static void bench_hash(void)
+{
+    double loads[] = {0.5, 0.75, 0.875};
+    size_t z, i;
+    printf("u64 -> u64 maps with %zu slots/buckets, ns per operation\n", HASH_SLOTS);
+    for (z = 0; z < sizeof(loads) / sizeof(loads[0]); z++)
+    {
+        size_t n = (size_t)(loads[z] * HASH_SLOTS), hits = 0;
+        uint64_t seed = 42, *keys = vector_init(sizeof(uint64_t), 2 * n, &a), *probe;
+        double t0, t1, t2, t3;
+
+        /* Inserted keys, then as many absent ones; lookups run in a shuffled order */
+        for (i = 0; i < 2 * n; i++)
+            vector_push_back(keys, xorshift64(&seed));
+        probe = vector_init(sizeof(uint64_t), 2 * n, &a);
+        memcpy(probe, keys, 2 * n * sizeof(uint64_t));
+        for (i = n; i > 1; i--)
+        {
+            size_t j = xorshift64(&seed) % i;
+            uint64_t t = probe[i - 1];
+            probe[i - 1] = probe[j];
+            probe[j] = t;
+        }
+
+        vector_hash_t *h = vector_hash(uint64_t, uint64_t, vector_hash_u64, u64_cmp, &a);
+        vector_hash_reserve(h, n);
+        t0 = now_sec();
+        for (i = 0; i < n; i++)
+            vector_hash_insert(h, &keys[i], &i);
+        t1 = now_sec();
+        for (i = 0; i < n; i++)
+            hits += vector_hash_find(h, &probe[i]) != NULL;
+        t2 = now_sec();
+        for (i = n; i < 2 * n; i++)
+            hits += vector_hash_find(h, &probe[i]) != NULL;
+        t3 = now_sec();
+        printf("  load %.3f: swiss insert %5.1f hit %5.1f miss %5.1f",
+               (double)n / vector_hash_cap(h), (t1 - t0) * 1e9 / n, (t2 - t1) * 1e9 / n, (t3 - t2) * 1e9 / n);
+        vector_hash_free(h);
+
+        bench_chain_t c;
+        c.buckets = calloc(HASH_SLOTS, sizeof(bench_chain_node_t *));
+        c.mask = HASH_SLOTS - 1;
+        t0 = now_sec();
+        for (i = 0; i < n; i++)
+            bench_chain_insert(&c, keys[i], i);
+        t1 = now_sec();
+        for (i = 0; i < n; i++)
+            hits += bench_chain_find(&c, probe[i]) != NULL;
+        t2 = now_sec();
+        for (i = n; i < 2 * n; i++)
+            hits += bench_chain_find(&c, probe[i]) != NULL;
+        t3 = now_sec();
+        printf(" | chained insert %5.1f hit %5.1f miss %5.1f (%zu)\n",
+               (t1 - t0) * 1e9 / n, (t2 - t1) * 1e9 / n, (t3 - t2) * 1e9 / n, hits);
+        bench_chain_free(&c);
+        vector_free(probe);
+        vector_free(keys);
+    }
+}
+
+#define HEAP_OPS 10000000
+
+VECTOR_HEAP_DEFINE(u64_2, uint64_t, U64_LESS, 2)
+VECTOR_HEAP_DEFINE(u64_4, uint64_t, U64_LESS, 4)
+
+/* HEAP_OPS / 2 random pushes, then as many pops */
+#define BENCH_HEAP_RUN(label, PUSH, POP)                                                       \
+    do                                                                                         \
+    {                                                                                          \
+        uint64_t *h = vector_init(sizeof(uint64_t), HEAP_OPS / 2, &a), seed = 42, x, sum = 0; \
+        double t0 = now_sec();                                                                 \
+        for (i = 0; i < HEAP_OPS / 2; i++)                                                     \
+        {                                                                                      \
+            x = xorshift64(&seed);                                                             \
+            PUSH;                                                                              \
+        }                                                                                      \
+        double t1 = now_sec();                                                                 \
+        for (i = 0; i < HEAP_OPS / 2; i++)                                                     \
+        {                                                                                      \
+            POP;                                                                               \
+            sum += x >> 40;                                                                    \
+        }                                                                                      \
+        double t2 = now_sec();                                                                 \
+        printf("  %-16s push %6.1f ns  pop %6.1f ns  total %5.2f s (%llu)\n", label,           \
+               (t1 - t0) * 2e9 / HEAP_OPS, (t2 - t1) * 2e9 / HEAP_OPS, t2 - t0,                \
+               (unsigned long long)sum);                                                       \
+        vector_free(h);                                                                        \
+    } while (0)
+
+static void bench_heap(void)
+{
+    size_t i;
+    printf("Priority queue of u64, %d operations\n", HEAP_OPS);
+    BENCH_HEAP_RUN("typed 2-ary", vector_heap_push_u64_2(&h, x), vector_heap_pop_u64_2(h, &x));
+    BENCH_HEAP_RUN("typed 4-ary", vector_heap_push_u64_4(&h, x), vector_heap_pop_u64_4(h, &x));
+    BENCH_HEAP_RUN("generic 2-ary", vector_heap_push(h, &x, 2, u64_cmp), vector_heap_pop(h, &x, 2, u64_cmp));
+    BENCH_HEAP_RUN("generic 4-ary", vector_heap_push(h, &x, 4, u64_cmp), vector_heap_pop(h, &x, 4, u64_cmp));
+}
+
+#define POOL_ROUNDS 2000000
+#define POOL_LIVE 256
+
+/* Handler-like churn: replace a random one of POOL_LIVE vectors with a new one grown by pushes */
+static double bench_pool_run(allocator_t *alloc)
+{
+    int *live[POOL_LIVE] = {0};
+    uint64_t seed = 42;
+    size_t r, i;
+    double t0 = now_sec();
+    for (r = 0; r < POOL_ROUNDS; r++)
+    {
+        size_t slot = xorshift64(&seed) % POOL_LIVE, n = xorshift64(&seed) % 100;
+        if (live[slot])
+            vector_free(live[slot]);
+        live[slot] = vector_init(sizeof(int), VECTOR_DEFAULT_CAP, alloc);
+        for (i = 0; i < n; i++)
+            vector_push_back(live[slot], (int)i);
+    }
+    for (i = 0; i < POOL_LIVE; i++)
+        if (live[i])
+            vector_free(live[i]);
+    return now_sec() - t0;
+}
+
+static void bench_pool(void)
+{
+    printf("%d vector lifetimes, up to 100 pushes each, %d alive at once\n", POOL_ROUNDS, POOL_LIVE);
+    printf("  malloc/realloc/free: %.3f s\n", bench_pool_run(&a));
+    printf("  vector_pool:         %.3f s\n", bench_pool_run(&vector_pool_allocator));
+    vector_pool_trim();
+}
+
+#define COMPACT_VECTORS 10000000
+
+/* Resident set size in bytes, 0 when /proc is unavailable */
+static size_t rss_bytes(void)
+{
+    unsigned long pages = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f)
+        return 0;
+    if (fscanf(f, "%lu %lu", &pages, &resident) != 2)
+        resident = 0;
+    fclose(f);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/* Each variant runs in a child process so freed memory cannot be reused by the next one */
+static void bench_compact_child(int compact)
+{
+    void **lists = malloc(COMPACT_VECTORS * sizeof(void *));
+    uint64_t seed = 42;
+    size_t i, j, items = 0;
+    memset(lists, 0, COMPACT_VECTORS * sizeof(void *));
+    size_t before = rss_bytes();
+    double t0 = now_sec();
+    for (i = 0; i < COMPACT_VECTORS; i++)
+    {
+        size_t n = xorshift64(&seed) % 9; /* adjacency lists of 0-8 ints */
+        int *v = compact ? vector_compact_init(sizeof(int), 0, &a) : vector_init(sizeof(int), 0, &a);
+        for (j = 0; j < n; j++)
+        {
+            if (compact)
+                vector_compact_push_back(v, (int)j);
+            else
+                vector_push_back(v, (int)j);
+        }
+        lists[i] = compact ? vector_compact_shrink_to_fit(v) : vector_shrink_to_fit(v);
+        items += n;
+    }
+    double t1 = now_sec();
+    size_t used = rss_bytes() - before;
+    printf("  %-9s %6.1f bytes/vector resident (payload %.1f), built in %.2f s\n",
+           compact ? "compact:" : "vector.h:", (double)used / COMPACT_VECTORS,
+           (double)items * sizeof(int) / COMPACT_VECTORS, t1 - t0);
+}
+
+static void bench_compact(void)
+{
+    int compact;
+    printf("%d small int vectors, shrunk to fit\n", COMPACT_VECTORS);
+    fflush(stdout);
+    for (compact = 0; compact < 2; compact++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            bench_compact_child(compact);
+            fflush(stdout);
+            _exit(0);
+        }
+        if (pid > 0)
+            waitpid(pid, NULL, 0);
+    }
+}
+
+#define CSR_ROWS 1000000
+#define CSR_EDGES 16000000
+#define CSR_PASSES 10
+
+static void bench_csr(void)
+{
+    int **rows = vector_init(sizeof(int *), CSR_ROWS, &a), *p;
+    uint32_t *order = malloc(CSR_ROWS * sizeof(uint32_t));
+    uint64_t seed = 42, sum = 0;
+    size_t i, r, k, len;
+    for (r = 0; r < CSR_ROWS; r++)
+        vector_push_back(rows, vector_init(sizeof(int), 0, &a));
+    /* Edges arrive in random order, so the rows grow interleaved across the heap */
+    for (i = 0; i < CSR_EDGES; i++)
+    {
+        r = xorshift64(&seed) % CSR_ROWS;
+        vector_push_back(rows[r], (int)(i & 0xffff));
+    }
+    for (r = 0; r < CSR_ROWS; r++)
+        order[r] = (uint32_t)r;
+    for (r = CSR_ROWS; r > 1; r--)
+    {
+        size_t j = xorshift64(&seed) % r;
+        uint32_t t = order[r - 1];
+        order[r - 1] = order[j];
+        order[j] = t;
+    }
+    vector_csr_t g;
+    double t0 = now_sec();
+    vector_flatten_csr(rows, sizeof(int), &g);
+    double t1 = now_sec();
+    printf("%d rows, %d ints, flattened in %.3f s, edges per second over %d passes:\n", CSR_ROWS, CSR_EDGES,
+           t1 - t0, CSR_PASSES);
+
+    t0 = now_sec();
+    for (k = 0; k < CSR_PASSES; k++)
+        for (r = 0; r < CSR_ROWS; r++)
+        {
+            vector_get_len(rows[r], &len);
+            for (i = 0; i < len; i++)
+                sum += rows[r][i];
+        }
+    t1 = now_sec();
+    printf("  rows in order:  nested %6.0f M/s", (double)CSR_EDGES * CSR_PASSES / (t1 - t0) / 1e6);
+    t0 = now_sec();
+    for (k = 0; k < CSR_PASSES; k++)
+        for (r = 0; r < CSR_ROWS; r++)
+            vector_csr_foreach(p, &g, r)
+                sum += *p;
+    t1 = now_sec();
+    printf(", csr %6.0f M/s\n", (double)CSR_EDGES * CSR_PASSES / (t1 - t0) / 1e6);
+
+    t0 = now_sec();
+    for (k = 0; k < CSR_PASSES; k++)
+        for (r = 0; r < CSR_ROWS; r++)
+        {
+            int *row = rows[order[r]];
+            vector_get_len(row, &len);
+            for (i = 0; i < len; i++)
+                sum += row[i];
+        }
+    t1 = now_sec();
+    printf("  rows shuffled:  nested %6.0f M/s", (double)CSR_EDGES * CSR_PASSES / (t1 - t0) / 1e6);
+    t0 = now_sec();
+    for (k = 0; k < CSR_PASSES; k++)
+        for (r = 0; r < CSR_ROWS; r++)
+            vector_csr_foreach(p, &g, order[r])
+                sum += *p;
+    t1 = now_sec();
+    printf(", csr %6.0f M/s (%llu)\n", (double)CSR_EDGES * CSR_PASSES / (t1 - t0) / 1e6, (unsigned long long)sum);
+
+    for (r = 0; r < CSR_ROWS; r++)
+        vector_free(rows[r]);
+    vector_free(rows);
+    vector_csr_free(&g);
+    free(order);
+}
+
+#define DETACH_ITEMS 4000000
+#define DETACH_ROUNDS 50
+
+static void bench_detach(void)
+{
+    int *v = vector_init(sizeof(int), DETACH_ITEMS, &a), *raw;
+    size_t i, len;
+    uint64_t sum = 0;
+    for (i = 0; i < DETACH_ITEMS; i++)
+        vector_push_back(v, (int)i);
+    double t0 = now_sec();
+    for (i = 0; i < DETACH_ROUNDS; i++)
+    {
+        raw = vector_normal_copy(v, malloc);
+        sum += raw[i];
+        free(raw);
+    }
+    double t1 = now_sec();
+    printf("%d ints to a plain array and back: normal_copy %.3f ms", DETACH_ITEMS,
+           (t1 - t0) * 1e3 / DETACH_ROUNDS);
+    t0 = now_sec();
+    for (i = 0; i < DETACH_ROUNDS; i++)
+    {
+        raw = vector_detach(v, &len);
+        sum += raw[i];
+        v = vector_adopt(raw, sizeof(int), len, len, &a);
+    }
+    t1 = now_sec();
+    printf(", detach+adopt %.3f ms (%llu)\n", (t1 - t0) * 1e3 / DETACH_ROUNDS, (unsigned long long)sum);
+    vector_free(v);
+}
+
+#define CLONE_ITEMS 1000
+#define CLONE_ROUNDS 200000
+#define CONCAT_PARTS 64
+
+static void bench_clone(void)
+{
+    int *v = vector_init(sizeof(int), CLONE_ITEMS, &a), *c;
+    void *parts[CONCAT_PARTS];
+    size_t i, k, len;
+    uint64_t sum = 0;
+    for (i = 0; i < CLONE_ITEMS; i++)
+        vector_push_back(v, (int)i);
+    vector_get_len(v, &len);
+    double t0 = now_sec();
+    for (i = 0; i < CLONE_ROUNDS; i++)
+    {
+        c = vector_init(sizeof(int), 0, &a);
+        vector_push_many(c, v, len);
+        sum += c[i % CLONE_ITEMS];
+        vector_free(c);
+    }
+    double t1 = now_sec();
+    printf("%d ints per clone: init+push_many %.1f ns", CLONE_ITEMS, (t1 - t0) * 1e9 / CLONE_ROUNDS);
+    t0 = now_sec();
+    for (i = 0; i < CLONE_ROUNDS; i++)
+    {
+        c = vector_clone(v);
+        sum += c[i % CLONE_ITEMS];
+        vector_free(c);
+    }
+    t1 = now_sec();
+    printf(", clone %.1f ns\n", (t1 - t0) * 1e9 / CLONE_ROUNDS);
+
+    for (k = 0; k < CONCAT_PARTS; k++)
+        parts[k] = v;
+    t0 = now_sec();
+    for (i = 0; i < CLONE_ROUNDS / CONCAT_PARTS; i++)
+    {
+        c = vector_init(sizeof(int), 0, &a);
+        for (k = 0; k < CONCAT_PARTS; k++)
+            vector_push_many(c, (int *)parts[k], len);
+        sum += c[i];
+        vector_free(c);
+    }
+    t1 = now_sec();
+    printf("%d parts per join: push_many %.1f us", CONCAT_PARTS, (t1 - t0) * 1e6 / (CLONE_ROUNDS / CONCAT_PARTS));
+    t0 = now_sec();
+    for (i = 0; i < CLONE_ROUNDS / CONCAT_PARTS; i++)
+    {
+        c = vector_concat(parts, CONCAT_PARTS);
+        sum += c[i];
+        vector_free(c);
+    }
+    t1 = now_sec();
+    printf(", concat %.1f us (%llu)\n", (t1 - t0) * 1e6 / (CLONE_ROUNDS / CONCAT_PARTS), (unsigned long long)sum);
+    vector_free(v);
+}
+
+#define PIPE_ITEMS 10000000
+#define PIPE_ROUNDS 10
+
+static void bench_pipeline(void)
+{
+    int *v = vector_init(sizeof(int), PIPE_ITEMS, &a), x;
+    long y;
+    size_t i, k, len;
+    long sum = 0;
+    for (i = 0; i < PIPE_ITEMS; i++)
+        vector_push_back(v, (int)i);
+    /* Filter, map, then reduce, one vector_foreach and intermediate vector per stage */
+    double t0 = now_sec();
+    for (k = 0; k < PIPE_ROUNDS; k++)
+    {
+        int *kept = vector_init(sizeof(int), 0, &a);
+        long *squares = vector_init(sizeof(long), 0, &a);
+        vector_foreach_ansi(i, len, v, x)
+            if (x % 3 == 0)
+                vector_push_back(kept, x);
+        vector_foreach_ansi(i, len, kept, x)
+            vector_push_back(squares, (long)x * 7);
+        vector_foreach_ansi(i, len, squares, y)
+            sum += y;
+        vector_free(kept);
+        vector_free(squares);
+    }
+    double t1 = now_sec();
+    printf("%d ints filter/map/reduce: staged %.2f ms", PIPE_ITEMS, (t1 - t0) * 1e3 / PIPE_ROUNDS);
+    t0 = now_sec();
+    for (k = 0; k < PIPE_ROUNDS; k++)
+    {
+        vector_pipe_begin(int, e, v)
+            vector_pipe_filter(e % 3 == 0)
+            vector_pipe_map(long, m, (long)e * 7)
+            vector_pipe_reduce(sum, sum + m)
+        vector_pipe_end;
+    }
+    t1 = now_sec();
+    printf(", fused %.2f ms (%ld)\n", (t1 - t0) * 1e3 / PIPE_ROUNDS, sum);
+    vector_free(v);
+}
+
+#define FOREACH_ITEMS 10000000
+#define FOREACH_ROWS 1000000
+#define FOREACH_ROUNDS 10
+
+static void bench_foreach(void)
+{
+    float *v = vector_init(sizeof(float), FOREACH_ITEMS, &a), *p, *end, x;
+    int **rows = vector_init(sizeof(int *), FOREACH_ROWS, &a), **row, **rows_end, *r;
+    size_t i, k, len;
+    double sum = 0;
+    long total = 0;
+    uint64_t seed = 7;
+    for (i = 0; i < FOREACH_ITEMS; i++)
+        vector_push_back(v, (float)(i & 1023));
+    double t0 = now_sec();
+    for (k = 0; k < FOREACH_ROUNDS; k++)
+        vector_foreach_ansi(i, len, v, x)
+            sum += x;
+    double t1 = now_sec();
+    printf("%d floats summed: foreach_ansi %.2f ms", FOREACH_ITEMS, (t1 - t0) * 1e3 / FOREACH_ROUNDS);
+    t0 = now_sec();
+    for (k = 0; k < FOREACH_ROUNDS; k++)
+    {
+        float acc = 0;
+        vector_foreach_ref(p, end, v)
+            acc += *p;
+        sum += acc;
+    }
+    t1 = now_sec();
+    printf(", foreach_ref %.2f ms (%.0f)\n", (t1 - t0) * 1e3 / FOREACH_ROUNDS, sum);
+
+    /* Rows allocated then shuffled, so consecutive rows are far apart */
+    for (i = 0; i < FOREACH_ROWS; i++)
+    {
+        r = vector_init(sizeof(int), 4, &a);
+        vector_push_back(r, (int)i);
+        vector_push_back(rows, r);
+    }
+    for (i = FOREACH_ROWS; i > 1; i--)
+    {
+        size_t j = xorshift64(&seed) % i;
+        r = rows[i - 1];
+        rows[i - 1] = rows[j];
+        rows[j] = r;
+    }
+    t0 = now_sec();
+    for (k = 0; k < FOREACH_ROUNDS; k++)
+        vector_foreach_ref(row, rows_end, rows)
+            total += (*row)[0];
+    t1 = now_sec();
+    printf("%d scattered rows: foreach_ref %.2f ms", FOREACH_ROWS, (t1 - t0) * 1e3 / FOREACH_ROUNDS);
+    t0 = now_sec();
+    for (k = 0; k < FOREACH_ROUNDS; k++)
+        vector_foreach_ref_prefetch(row, rows_end, rows, VECTOR_PREFETCH_DISTANCE)
+            total += (*row)[0];
+    t1 = now_sec();
+    printf(", prefetched %.2f ms (%ld)\n", (t1 - t0) * 1e3 / FOREACH_ROUNDS, total);
+
+    vector_foreach_ref(row, rows_end, rows)
+        vector_free(*row);
+    vector_free(rows);
+    vector_free(v);
+}
+
+/*  -------- Main Bench Runner -------- */
+
+/* Runs every bench, or only the ones named on the command line */
+static int selected(int argc, char **argv, const char *name)
+{
+    int i;
+    if (argc < 2)
+        return 1;
+    for (i = 1; i < argc; i++)
+        if (strcmp(argv[i], name) == 0)
+            return 1;
+    return 0;
+}
+
+#define BENCH_RUN(name)                   \
+    do                                    \
+    {                                     \
+        if (selected(argc, argv, #name)) \
+            bench_##name();               \
+        fflush(stdout);                   \
+    } while (0)
+
+int main(int argc, char **argv)
+{
+    BENCH_RUN(spsc);
+    BENCH_RUN(mpmc);
+    BENCH_RUN(parallel);
+    BENCH_RUN(scheduler);
+    BENCH_RUN(sort);
+    BENCH_RUN(soa);
+    BENCH_RUN(bits);
+    BENCH_RUN(rank);
+    BENCH_RUN(sorted);
+    BENCH_RUN(eytzinger);
+    BENCH_RUN(hash);
+    BENCH_RUN(heap);
+    BENCH_RUN(pool);
+    BENCH_RUN(compact);
+    BENCH_RUN(csr);
+    BENCH_RUN(detach);
+    BENCH_RUN(clone);
+    BENCH_RUN(pipeline);
+    BENCH_RUN(foreach);
+    return 0;
+}
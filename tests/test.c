@@ -1,9 +1,29 @@
 #include "../source/vector.h"
+#include "../source/vector_deque.h"
+#include "../source/vector_spsc.h"
+#include "../source/vector_mpmc.h"
+#include "../source/vector_append.h"
+#include "../source/vector_combinable.h"
+#include "../source/vector_parallel.h"
+#include "../source/vector_scheduler.h"
+#include "../source/vector_sort.h"
+#include "../source/vector_rrb.h"
+#include "../source/vector_soa.h"
+#include "../source/vector_pipeline.h"
+#include "../source/vector_bits.h"
+#include "../source/vector_sorted.h"
+#include "../source/vector_hash.h"
+#include "../source/vector_heap.h"
+#include "../source/vector_pool.h"
+#include "../source/vector_compact.h"
+#include "../source/vector_csr.h"
 
 #define CTF_TEST_NAMES
 #include "C-Testing-Framework/ctf.h"
 
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 
 allocator_t a = {malloc,realloc,free};
 
@@ -51,11 +71,1120 @@ TEST_MAKE(PopBack)
     TEST_PASS();
 }
 
+TEST_MAKE(DequeFifo)
+{
+    int *d = vector_deque(int, &a);
+    TEST_ASSERT(d != NULL);
+    int i, out;
+    for (i = 0; i < 100; i++)
+    {
+        vector_deque_push_back(d, i);
+        TEST_ASSERT(vector_deque_pop_front(d, &out) == VEC_OK);
+        TEST_ASSERT(out == i);
+    }
+    vector_deque_push_front(d, 1);
+    vector_deque_push_front(d, 0);
+    vector_deque_push_back(d, 2);
+    TEST_ASSERT(vector_deque_at(d, 0) == 0);
+    TEST_ASSERT(vector_deque_at(d, 2) == 2);
+    TEST_ASSERT(vector_deque_pop_back(d, &out) == VEC_OK && out == 2);
+    TEST_ASSERT(vector_deque_pop_front(d, &out) == VEC_OK && out == 0);
+    TEST_ASSERT(vector_deque_pop_front(d, &out) == VEC_OK && out == 1);
+    TEST_ASSERT(vector_deque_pop_front(d, &out) == VEC_EMPTY);
+    vector_deque_free(d);
+    TEST_PASS();
+}
+
+/* Fails every allocation while failing_now is set */
+static int failing_now;
+
+static void *failing_malloc(size_t size)
+{
+    return failing_now ? NULL : malloc(size);
+}
+
+static allocator_t failing = {failing_malloc, realloc, free};
+
+/* Hands out memory full of garbage, so headers must set every field */
+static void *dirty_malloc(size_t size)
+{
+    void *p = malloc(size);
+    if (p)
+        memset(p, 0xab, size);
+    return p;
+}
+
+static allocator_t dirty = {dirty_malloc, realloc, free};
+
+TEST_MAKE(DequeLinearize)
+{
+    int *d = vector_deque(int, &dirty), *copy;
+    int i;
+    for (i = 0; i < 10; i++)
+        vector_deque_push_back(d, i);
+    for (i = 1; i <= 30; i++)
+        vector_deque_push_front(d, -i); /* wraps and grows */
+    size_t len;
+    vector_get_len(d, &len);
+    TEST_ASSERT(len == 40);
+    d = vector_deque_linearize(d);
+    TEST_ASSERT(d != NULL);
+    for (i = 0; i < 40; i++)
+        TEST_ASSERT(d[i] == i - 30);
+    copy = vector_normal_copy(d, malloc);
+    TEST_ASSERT(copy && copy[39] == 9);
+    free(copy);
+    vector_deque_free(d);
+    TEST_PASS();
+}
+
+TEST_MAKE(SpscBatch)
+{
+    int *q = vector_spsc(int, 5, &a);
+    TEST_ASSERT(q != NULL);
+    size_t cap;
+    vector_get_cap(q, &cap);
+    TEST_ASSERT(cap == 8);
+    int in[6] = {1, 2, 3, 4, 5, 6}, out[8];
+    int round;
+    for (round = 0; round < 4; round++) /* indices wrap every other round */
+    {
+        TEST_ASSERT(vector_spsc_push_many(q, in, 6) == 6);
+        TEST_ASSERT(vector_spsc_push_many(q, in, 6) == 2);
+        TEST_ASSERT(vector_spsc_push(q, in) == VEC_FULL);
+        TEST_ASSERT(vector_spsc_size(q) == 8);
+        TEST_ASSERT(vector_spsc_pop_many(q, out, 8) == 8);
+        TEST_ASSERT(out[5] == 6 && out[6] == 1 && out[7] == 2);
+        TEST_ASSERT(vector_spsc_pop(q, out) == VEC_EMPTY);
+    }
+    vector_spsc_free(q);
+    TEST_PASS();
+}
+
+TEST_MAKE(MpmcBatch)
+{
+    long *q = vector_mpmc(long, 6, &a);
+    TEST_ASSERT(q != NULL);
+    long in[5] = {10, 20, 30, 40, 50}, out[8];
+    int round;
+    for (round = 0; round < 3; round++)
+    {
+        TEST_ASSERT(vector_mpmc_push(q, &in[4]) == VEC_OK);
+        TEST_ASSERT(vector_mpmc_push_many(q, in, 5) == 5);
+        TEST_ASSERT(vector_mpmc_push_many(q, in, 5) == 2);
+        TEST_ASSERT(vector_mpmc_push(q, in) == VEC_FULL);
+        TEST_ASSERT(vector_mpmc_pop(q, out) == VEC_OK && out[0] == 50);
+        TEST_ASSERT(vector_mpmc_pop_many(q, out, 8) == 7);
+        TEST_ASSERT(out[0] == 10 && out[4] == 50 && out[6] == 20);
+        TEST_ASSERT(vector_mpmc_pop(q, out) == VEC_EMPTY);
+    }
+    /* Zero counts return at once, empty or not */
+    TEST_ASSERT(vector_mpmc_push_many(q, in, 0) == 0 && vector_mpmc_pop_many(q, out, 0) == 0);
+    TEST_ASSERT(vector_mpmc_push(q, in) == VEC_OK);
+    TEST_ASSERT(vector_mpmc_push_many(q, in, 0) == 0 && vector_mpmc_pop_many(q, out, 0) == 0);
+    vector_mpmc_free(q);
+    TEST_PASS();
+}
+
+static void *append_worker(void *arg)
+{
+    vector_append_t *va = arg;
+    int i;
+    for (i = 0; i < 10000; i++)
+        *(int *)vector_append_emplace(va, NULL) = i;
+    return NULL;
+}
+
+TEST_MAKE(AppendConcurrentSeal)
+{
+    vector_append_t *va = vector_append_init(sizeof(int), 4, &a);
+    TEST_ASSERT(va != NULL);
+    pthread_t t[4];
+    int i;
+    for (i = 0; i < 4; i++)
+        pthread_create(&t[i], NULL, append_worker, va);
+    for (i = 0; i < 4; i++)
+        pthread_join(t[i], NULL);
+    TEST_ASSERT(vector_append_len(va) == 40000);
+    int *v = vector_append_seal(va);
+    TEST_ASSERT(v != NULL);
+    size_t len;
+    vector_get_len(v, &len);
+    TEST_ASSERT(len == 40000);
+    long sum = 0;
+    for (i = 0; i < 40000; i++)
+        sum += v[i];
+    TEST_ASSERT(sum == 4L * (9999L * 10000 / 2));
+    vector_push_back(v, 7); /* sealed result is a plain vector */
+    TEST_ASSERT(v[40000] == 7);
+    vector_free(v);
+
+    /* A push whose segment cannot be allocated reserves no slot */
+    va = vector_append_init(sizeof(int), 2, &failing);
+    for (i = 0; i < 2; i++)
+        TEST_ASSERT(vector_append_push(va, &i) == VEC_OK);
+    failing_now = 1;
+    TEST_ASSERT(vector_append_push(va, &i) == VEC_ERR);
+    failing_now = 0;
+    TEST_ASSERT(vector_append_len(va) == 3); /* the slot stays taken */
+    TEST_ASSERT(vector_append_push(va, &i) == VEC_OK);
+    TEST_ASSERT(vector_append_seal(va) == NULL); /* and holds no element */
+    TEST_PASS();
+}
+
+typedef struct
+{
+    vector_combinable_t *c;
+    size_t slot;
+} combinable_arg_t;
+
+static void *combinable_worker(void *arg)
+{
+    combinable_arg_t *w = arg;
+    int i, x = (int)w->slot;
+    for (i = 0; i < 1000 * (int)(w->slot + 1); i++)
+        vector_combinable_push(w->c, w->slot, &x);
+    return NULL;
+}
+
+TEST_MAKE(CombinableMerge)
+{
+    vector_combinable_t *c = vector_combinable(int, 4, &a);
+    TEST_ASSERT(c != NULL);
+    pthread_t t[4];
+    combinable_arg_t args[4];
+    size_t i;
+    for (i = 0; i < 4; i++)
+    {
+        args[i].c = c;
+        args[i].slot = i;
+        pthread_create(&t[i], NULL, combinable_worker, &args[i]);
+    }
+    for (i = 0; i < 4; i++)
+        pthread_join(t[i], NULL);
+    int *v = vector_combinable_merge(c, 3);
+    TEST_ASSERT(v != NULL);
+    size_t len, cap;
+    vector_get_len(v, &len);
+    vector_get_cap(v, &cap);
+    TEST_ASSERT(len == 10000 && cap == 10000);
+    TEST_ASSERT(v[0] == 0 && v[999] == 0 && v[1000] == 1 && v[2999] == 1 && v[3000] == 2 && v[9999] == 3);
+    vector_get_len(*vector_combinable_local(c, 2), &len);
+    TEST_ASSERT(len == 0);
+    for (i = 0; i < 4; i++)
+    {
+        void *mine = *vector_combinable_local(c, i);
+        vector_get_cap(mine, &cap);
+        TEST_ASSERT((uintptr_t)mine % 64 == 0 && cap * sizeof(int) % 64 == 0); /* still whole lines after growth */
+    }
+    vector_free(v);
+    vector_combinable_free(c);
+    TEST_PASS();
+}
+
+static void square_chunk(void *vector, size_t begin, size_t end, void *ctx)
+{
+    long *v = vector;
+    for (; begin < end; begin++)
+        v[begin] *= v[begin];
+}
+
+static void half_chunk(const void *in, void *out, size_t begin, size_t end, void *ctx)
+{
+    for (; begin < end; begin++)
+        ((double *)out)[begin] = ((const long *)in)[begin] / 2.0;
+}
+
+static void sum_chunk(const void *in, size_t begin, size_t end, void *partial, void *ctx)
+{
+    for (; begin < end; begin++)
+        *(double *)partial += ((const double *)in)[begin];
+}
+
+static void sum_combine(void *acc, const void *partial, void *ctx)
+{
+    *(double *)acc += *(const double *)partial;
+}
+
+TEST_MAKE(ParallelForMapReduce)
+{
+    long *v = vector(long, &a);
+    long i;
+    for (i = 0; i < 100000; i++)
+        vector_push_back(v, i);
+    TEST_ASSERT(vector_parallel_set_threads(3) == VEC_OK);
+    TEST_ASSERT(vector_parallel_for(v, square_chunk, NULL, 1000) == VEC_OK);
+    TEST_ASSERT(v[99999] == 99999L * 99999L);
+    double *h = vector_parallel_map(v, sizeof(double), half_chunk, NULL, 0);
+    TEST_ASSERT(h != NULL && h[3] == 4.5);
+    double sum = 0, det1 = 0, det2 = 0;
+    TEST_ASSERT(vector_parallel_reduce(h, &sum, sizeof(sum), sum_chunk, sum_combine, NULL, 0, 0) == VEC_OK);
+    TEST_ASSERT(sum > 1.66e14 && sum < 1.67e14);
+    vector_parallel_reduce(h, &det1, sizeof(det1), sum_chunk, sum_combine, NULL, 0, VECTOR_PARALLEL_DETERMINISTIC);
+    vector_parallel_set_threads(1);
+    vector_parallel_reduce(h, &det2, sizeof(det2), sum_chunk, sum_combine, NULL, 0, VECTOR_PARALLEL_DETERMINISTIC);
+    TEST_ASSERT(det1 == det2);
+    vector_parallel_set_threads(0);
+    vector_free(h);
+    vector_free(v);
+    TEST_PASS();
+}
+
+typedef struct
+{
+    vector_scheduler_t *s;
+    long n;
+    long result;
+} fib_arg_t;
+
+static void fib_task(void *arg)
+{
+    fib_arg_t *f = arg;
+    if (f->n < 2)
+    {
+        f->result = f->n;
+        return;
+    }
+    fib_arg_t x = {f->s, f->n - 1, 0}, y = {f->s, f->n - 2, 0};
+    vector_task_group_t g;
+    vector_task_group_init(&g);
+    vector_scheduler_spawn(f->s, &g, fib_task, &x);
+    fib_task(&y);
+    vector_scheduler_wait(f->s, &g);
+    f->result = x.result + y.result;
+}
+
+static void mark_chunk(void *vector, size_t begin, size_t end, void *ctx)
+{
+    for (; begin < end; begin++)
+        ((int *)vector)[begin] += 1;
+}
+
+TEST_MAKE(SchedulerSplit)
+{
+    vector_scheduler_t *s = vector_scheduler_create(3, &a);
+    TEST_ASSERT(s != NULL);
+    fib_arg_t f = {s, 20, 0};
+    vector_task_group_t g;
+    vector_task_group_init(&g);
+    TEST_ASSERT(vector_scheduler_spawn(s, &g, fib_task, &f) == VEC_OK);
+    vector_scheduler_wait(s, &g);
+    TEST_ASSERT(f.result == 6765);
+
+    int *v = vector(int, &a);
+    int i;
+    for (i = 0; i < 5000; i++)
+        vector_push_back(v, i);
+    TEST_ASSERT(vector_scheduler_for(s, v, mark_chunk, NULL, 7) == VEC_OK);
+    for (i = 0; i < 5000; i++)
+        TEST_ASSERT(v[i] == i + 1);
+    vector_free(v);
+    TEST_ASSERT(vector_scheduler_destroy(s) == VEC_OK);
+    TEST_PASS();
+}
+
+TEST_MAKE(CopyOnWrite)
+{
+    int *v = vector(int, &a);
+    int i, popped;
+    size_t len, refs;
+    for (i = 0; i < 10; i++)
+        vector_push_back(v, i);
+    int *r = vector_share(v);
+    TEST_ASSERT(r == v);
+    vector_get_refs(v, &refs);
+    TEST_ASSERT(refs == 2);
+
+    vector_push_back(v, 10);
+    TEST_ASSERT(r != v);
+    vector_get_len(r, &len);
+    TEST_ASSERT(len == 10);
+    vector_get_refs(r, &refs);
+    TEST_ASSERT(refs == 1);
+
+    /* In-place calls refuse a shared vector until it is made unique */
+    int *w = vector_share(r);
+    TEST_ASSERT(vector_remove((int *)w, 0) == VEC_SHARED);
+    TEST_ASSERT(vector_pop_back(w, &popped) == VEC_SHARED);
+    vector_unique(w);
+    TEST_ASSERT(vector_remove(w, 0) == VEC_OK);
+    TEST_ASSERT(vector_pop_back(w, &popped) == VEC_OK);
+    TEST_ASSERT(w != r && popped == 9);
+    vector_get_len(r, &len);
+    TEST_ASSERT(len == 10 && r[0] == 0 && r[9] == 9);
+
+    /* A failed copy leaves the pointer and its reference alone */
+    int *f = vector(int, &failing), *g;
+    vector_push_back(f, 1);
+    g = vector_share(f);
+    failing_now = 1;
+    vector_unique(g);
+    failing_now = 0;
+    TEST_ASSERT(g == f && vector_remove(g, 0) == VEC_SHARED);
+    vector_free(g);
+    vector_free(f);
+
+    vector_free(v);
+    vector_free(w);
+    vector_free(r);
+    TEST_PASS();
+}
+
+TEST_MAKE(RrbVersions)
+{
+    int *v = vector(int, &a);
+    int i, x = -1;
+    for (i = 0; i < 5000; i++)
+        vector_push_back(v, i);
+    vector_rrb_t *r0 = vector_rrb_from_vector(v);
+    vector_rrb_t *r1 = vector_rrb_set(r0, 1234, &x);
+    vector_rrb_t *r2 = vector_rrb_push(r1, &x);
+    TEST_ASSERT(r0 && r1 && r2);
+    TEST_ASSERT(vector_rrb_get(int, r0, 1234) == 1234);
+    TEST_ASSERT(vector_rrb_get(int, r1, 1234) == -1);
+    TEST_ASSERT(vector_rrb_len(r1) == 5000 && vector_rrb_len(r2) == 5001);
+
+    /* Reassemble r0 from uneven slices */
+    vector_rrb_t *head = vector_rrb_slice(r0, 0, 77);
+    vector_rrb_t *mid = vector_rrb_slice(r0, 77, 3001);
+    vector_rrb_t *tail = vector_rrb_slice(r0, 3001, 5000);
+    vector_rrb_t *hm = vector_rrb_concat(head, mid);
+    vector_rrb_t *all = vector_rrb_concat(hm, tail);
+    int *w = vector_rrb_to_vector(all);
+    size_t len;
+    vector_get_len(w, &len);
+    TEST_ASSERT(len == 5000 && memcmp(v, w, 5000 * sizeof(int)) == 0);
+
+    vector_rrb_free(r0);
+    TEST_ASSERT(vector_rrb_get(int, all, 4999) == 4999);
+    vector_rrb_free(r1);
+    vector_rrb_free(r2);
+    vector_rrb_free(head);
+    vector_rrb_free(mid);
+    vector_rrb_free(tail);
+    vector_rrb_free(hm);
+    vector_rrb_free(all);
+    vector_free(v);
+    vector_free(w);
+    TEST_PASS();
+}
+
+typedef struct
+{
+    uint64_t id;
+    float x, y, z;
+    uint8_t flags;
+} particle_t;
+
+#define PARTICLE_FIELDS(X) X(uint64_t, id) X(float, x) X(float, y) X(float, z) X(uint8_t, flags)
+VECTOR_SOA_DEFINE(particle, particle_t, PARTICLE_FIELDS)
+
+TEST_MAKE(SoaColumns)
+{
+    vector_soa_particle_t ps;
+    particle_t p = {0, 0.0f, 1.0f, 2.0f, 0}, q;
+    size_t i;
+    TEST_ASSERT(vector_soa_particle_init(&ps, 0, &a) == VEC_OK);
+    for (i = 0; i < 1000; i++)
+    {
+        p.id = i;
+        p.flags = (uint8_t)(i & 1);
+        TEST_ASSERT(vector_soa_particle_push(&ps, &p) == VEC_OK);
+    }
+    TEST_ASSERT(((uintptr_t)ps.x % VECTOR_SOA_ALIGN) == 0 && ((uintptr_t)ps.flags % VECTOR_SOA_ALIGN) == 0);
+    for (i = 0; i < ps.len; i++)
+        ps.x[i] += (float)ps.id[i];
+    TEST_ASSERT(vector_soa_particle_get(&ps, 999, &q) == VEC_OK);
+    TEST_ASSERT(q.id == 999 && q.x == 999.0f && q.z == 2.0f && q.flags == 1);
+
+    particle_t *aos = vector_soa_particle_to_aos(&ps);
+    vector_soa_particle_t back;
+    vector_soa_particle_init(&back, 0, &a);
+    TEST_ASSERT(vector_soa_particle_from_aos(&back, aos) == VEC_OK);
+    TEST_ASSERT(back.len == 1000 && back.x[500] == 500.0f && back.y[500] == 1.0f);
+    vector_free(aos);
+    vector_soa_particle_free(&ps);
+    vector_soa_particle_free(&back);
+    TEST_PASS();
+}
+
+TEST_MAKE(BitsOps)
+{
+    uint64_t *x = vector_bits(&a), *y = vector_bits_init(0, &a);
+    size_t i, n = 0;
+    for (i = 0; i < 1000; i++)
+    {
+        vector_bits_push(x, i % 3 == 0);
+        vector_bits_push(y, i % 2 == 0);
+    }
+    TEST_ASSERT(vector_bits_len(x) == 1000 && vector_bits_count(x) == 334);
+    TEST_ASSERT(vector_bits_and(x, y) == VEC_OK && vector_bits_count(x) == 167);
+    vector_bits_foreach(i, x)
+    {
+        TEST_ASSERT(i % 6 == 0);
+        n++;
+    }
+    TEST_ASSERT(n == 167);
+    TEST_ASSERT(vector_bits_not(x) == VEC_OK && vector_bits_count(x) == 833);
+    TEST_ASSERT(vector_bits_next(y, 999) == 1000);
+
+    x = vector_bits_resize(x, 1001);
+    TEST_ASSERT(x && vector_bits_and(x, y) == VEC_ERR && vector_bits_get(x, 1000) == 0);
+    vector_bits_set(x, 1000);
+    vector_bits_clear(x, 1);
+    TEST_ASSERT(vector_bits_count(x) == 833 && vector_bits_get(x, 1000) == 1);
+    vector_free(x);
+    vector_free(y);
+    TEST_PASS();
+}
+
+TEST_MAKE(BitsRankSelect)
+{
+    uint64_t *bv = vector_bits_init(0, &a);
+    size_t i, ones = 0;
+    bv = vector_bits_resize(bv, 100003);
+    for (i = 0; i < 100003; i += 1 + i % 7)
+        vector_bits_set(bv, i);
+    vector_bits_rank_t *r = vector_bits_rank_init(bv);
+    TEST_ASSERT(r != NULL);
+    for (i = 0; i <= 100003; i++)
+    {
+        TEST_ASSERT(vector_bits_rank(r, i) == ones);
+        if (i < 100003 && vector_bits_get(bv, i))
+        {
+            TEST_ASSERT(vector_bits_select(r, ones) == i);
+            ones++;
+        }
+    }
+    TEST_ASSERT(vector_bits_select(r, ones) == 100003);
+    TEST_ASSERT(vector_bits_rank_bytes(r) * 20 < 100003 / 8);
+    vector_bits_rank_free(r);
+    vector_free(bv);
+    TEST_PASS();
+}
+
+#define INT_LESS(x, y) ((x) < (y))
+VECTOR_SORT_DEFINE(int, int, INT_LESS)
+
+static int int_cmp(const void *x, const void *y)
+{
+    int l = *(const int *)x, r = *(const int *)y;
+    return (l > r) - (l < r);
+}
+
+TEST_MAKE(ParallelSort)
+{
+    int *v = vector(int, &a), *w = vector(int, &a), *s = vector(int, &a);
+    unsigned x = 12345;
+    int i;
+    for (i = 0; i < 200000; i++)
+    {
+        x = x * 1103515245u + 12345u;
+        vector_push_back(v, (int)(x >> 8) % 1000);
+        vector_push_back(w, v[i]);
+        vector_push_back(s, v[i]);
+    }
+    TEST_ASSERT(vector_parallel_sort(v, int_cmp) == VEC_OK);
+    TEST_ASSERT(vector_parallel_sort_int(w) == VEC_OK);
+    vector_sort_int(s);
+    for (i = 1; i < 200000; i++)
+        TEST_ASSERT(v[i - 1] <= v[i]);
+    TEST_ASSERT(memcmp(v, w, 200000 * sizeof(int)) == 0);
+    TEST_ASSERT(memcmp(v, s, 200000 * sizeof(int)) == 0);
+
+    /* Sorting a shared vector would reorder the other owner's view */
+    int *r = vector(int, &a), *u;
+    for (i = 10; i > 0; i--)
+        vector_push_back(r, i);
+    u = vector_share(r);
+    TEST_ASSERT(vector_parallel_sort(u, int_cmp) == VEC_SHARED && vector_parallel_sort_int(u) == VEC_SHARED);
+    TEST_ASSERT(r[0] == 10);
+    vector_unique(u);
+    TEST_ASSERT(vector_parallel_sort(u, int_cmp) == VEC_OK && u[0] == 1 && r[0] == 10);
+    vector_free(u);
+    vector_free(r);
+    vector_free(v);
+    vector_free(w);
+    vector_free(s);
+    TEST_PASS();
+}
+
+VECTOR_SORTED_DEFINE(int, int, INT_LESS)
+
+TEST_MAKE(SortedSet)
+{
+    int *v = vector(int, &a);
+    int i, k;
+    size_t len;
+    for (i = 0; i < 100; i++)
+        vector_push_back(v, (i * 37) % 50);
+    TEST_ASSERT(vector_sorted_build(v, int_cmp) == VEC_OK);
+    vector_get_len(v, &len);
+    TEST_ASSERT(len == 50);
+    for (i = 0; i < 50; i++)
+        TEST_ASSERT(v[i] == i);
+
+    k = 100;
+    vector_sorted_insert(v, &k, int_cmp);
+    k = -5;
+    vector_sorted_insert(v, &k, int_cmp);
+    k = 20;
+    vector_sorted_insert(v, &k, int_cmp);
+    vector_get_len(v, &len);
+    TEST_ASSERT(len == 52 && v[0] == -5 && v[51] == 100);
+    TEST_ASSERT(vector_sorted_erase(v, &k, int_cmp) == VEC_OK);
+    TEST_ASSERT(vector_sorted_erase(v, &k, int_cmp) == VEC_INDEX_OOB);
+    TEST_ASSERT(vector_sorted_find(v, &k, int_cmp) == NULL);
+    k = 21;
+    TEST_ASSERT(vector_sorted_find(v, &k, int_cmp) == &v[21]);
+    TEST_ASSERT(vector_lower_bound(v, &k, int_cmp) == 21 && vector_lower_bound_int(v, 21) == 21);
+    TEST_ASSERT(vector_lower_bound_int(v, 20) == 21 && vector_lower_bound_int(v, 1000) == 51);
+    vector_free(v);
+    TEST_PASS();
+}
+
+TEST_MAKE(EytzingerSearch)
+{
+    int i, k, n;
+    int *w = vector_init_aligned(sizeof(int), 1, 64, &a);
+    for (i = 0; i < 100; i++)
+        vector_push_back(w, i);
+    TEST_ASSERT((uintptr_t)w % 64 == 0 && w[99] == 99);
+    vector_free(w);
+
+    for (n = 0; n < 70; n++)
+    {
+        int *v = vector(int, &a);
+        for (i = 0; i < n; i++)
+            vector_push_back(v, 2 * i);
+        int *e = vector_eytzinger_build(v);
+        TEST_ASSERT(e && (uintptr_t)e % 64 == 0);
+        for (k = -1; k <= 2 * n; k++)
+        {
+            size_t want = vector_lower_bound(v, &k, int_cmp);
+            TEST_ASSERT(vector_eytzinger_lower_bound(e, &k, int_cmp) == want);
+            TEST_ASSERT(vector_eytzinger_lower_bound_int(e, k) == want);
+        }
+        vector_free(e);
+        vector_free(v);
+    }
+    TEST_PASS();
+}
+
+static int u64_cmp(const void *x, const void *y)
+{
+    uint64_t l = *(const uint64_t *)x, r = *(const uint64_t *)y;
+    return (l > r) - (l < r);
+}
+
+TEST_MAKE(HashMap)
+{
+    vector_hash_t *h = vector_hash(uint64_t, int, vector_hash_u64, u64_cmp, &a);
+    uint64_t k;
+    int v;
+    size_t i, n = 0;
+    TEST_ASSERT(h);
+    for (k = 0; k < 1000; k++)
+    {
+        v = (int)k * 3;
+        TEST_ASSERT(vector_hash_insert(h, &k, &v));
+    }
+    TEST_ASSERT(vector_hash_len(h) == 1000);
+    for (k = 0; k < 1000; k += 2)
+        TEST_ASSERT(vector_hash_erase(h, &k) == VEC_OK);
+    TEST_ASSERT(vector_hash_erase(h, &k) == VEC_INDEX_OOB);
+    for (k = 0; k < 1000; k++)
+    {
+        int *found = vector_hash_find(h, &k);
+        TEST_ASSERT(k % 2 ? found && *found == (int)k * 3 : !found);
+    }
+
+    /* Churn through tombstones, then assign over existing keys */
+    for (k = 1000; k < 20000; k++)
+    {
+        TEST_ASSERT(vector_hash_insert(h, &k, NULL));
+        TEST_ASSERT(vector_hash_erase(h, &k) == VEC_OK);
+    }
+    k = 7;
+    v = -1;
+    vector_hash_insert(h, &k, &v);
+    TEST_ASSERT(vector_hash_len(h) == 500 && *(int *)vector_hash_find(h, &k) == -1);
+
+    TEST_ASSERT(vector_hash_reserve(h, 5000) == VEC_OK);
+    size_t cap = vector_hash_cap(h);
+    for (k = 2000; k < 6500; k++)
+        vector_hash_insert(h, &k, NULL);
+    TEST_ASSERT(vector_hash_cap(h) == cap);
+    TEST_ASSERT(vector_hash_rehash(h, 0) == VEC_OK && vector_hash_cap(h) == cap);
+    vector_hash_foreach(i, h)
+        n++;
+    TEST_ASSERT(n == 5000 && vector_hash_len(h) == 5000);
+    vector_hash_free(h);
+    TEST_PASS();
+}
+
+VECTOR_HEAP_DEFINE(int, int, INT_LESS, 4)
+
+TEST_MAKE(HeapOrder)
+{
+    int *v = vector(int, &a), *w = vector(int, &a);
+    int i, x, prev;
+    unsigned seed = 1;
+    for (i = 0; i < 1000; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        x = (int)(seed >> 16) % 500;
+        vector_push_back(v, x);
+        TEST_ASSERT(vector_heap_push_int(&w, x) == VEC_OK);
+    }
+
+    /* Generic heap with an odd arity, built in one pass */
+    TEST_ASSERT(vector_heapify(v, 3, int_cmp) == VEC_OK);
+    for (i = 0, prev = -1; i < 1000; i++)
+    {
+        TEST_ASSERT(vector_heap_pop(v, &x, 3, int_cmp) == VEC_OK && x >= prev);
+        prev = x;
+        if (i % 4 == 0)
+        {
+            x += 7;
+            vector_heap_push(v, &x, 3, int_cmp);
+        }
+    }
+    while (vector_heap_pop(v, &x, 3, int_cmp) == VEC_OK)
+    {
+        TEST_ASSERT(x >= prev);
+        prev = x;
+    }
+
+    /* Typed 4-ary heap filled by pushes */
+    for (i = 0, prev = -1; i < 1000; i++)
+    {
+        TEST_ASSERT(vector_heap_pop_int(w, &x) == VEC_OK && x >= prev);
+        prev = x;
+    }
+    TEST_ASSERT(vector_heap_pop_int(w, &x) == VEC_EMPTY);
+    vector_free(v);
+    vector_free(w);
+    TEST_PASS();
+}
+
+static void *pool_worker(void *arg)
+{
+    int **v = arg;
+    int i;
+    for (i = 0; i < 1000; i++)
+        vector_push_back(*v, i);
+    vector_free(*v);
+    *v = vector_init(sizeof(int), 100, &vector_pool_allocator);
+    return NULL;
+}
+
+#define POOL_SPARE 8
+
+/* Allocates and frees POOL_SPARE blocks, which reach the shared list when the thread exits */
+static void *pool_spare_worker(void *arg)
+{
+    void **blocks = arg;
+    int i;
+    for (i = 0; i < POOL_SPARE; i++)
+        blocks[i] = vector_pool_malloc(100000);
+    for (i = 0; i < POOL_SPARE; i++)
+        vector_pool_free(blocks[i]);
+    return NULL;
+}
+
+/* Only allocates, the rest of what it pulled from the shared list must go back on exit */
+static void *pool_taker_worker(void *arg)
+{
+    (void)arg;
+    return vector_pool_malloc(100000);
+}
+
+TEST_MAKE(PoolRecycle)
+{
+    int *v = vector_init(sizeof(int), 100, &vector_pool_allocator), *w;
+    int i;
+    TEST_ASSERT(v);
+    vector_free(v);
+    w = vector_init(sizeof(int), 90, &vector_pool_allocator);
+    TEST_ASSERT(w == v); /* same size class, straight from this thread's cache */
+
+    /* A resize that stays inside the block's size class keeps the block */
+    w = vector_resize(w, 105);
+    TEST_ASSERT(w == v);
+    for (i = 0; i < 111; i++)
+        vector_push_back(w, i);
+    TEST_ASSERT(w != v && w[110] == 110);
+
+    /* Blocks cross threads, and large ones bypass the classes */
+    pthread_t t;
+    pthread_create(&t, NULL, pool_worker, &w);
+    pthread_join(t, NULL);
+    int *big = vector_init(sizeof(int), 1 << 20, &vector_pool_allocator);
+    TEST_ASSERT(w && big);
+    big = vector_resize(big, 1 << 21);
+    big[(1 << 21) - 1] = 7;
+    TEST_ASSERT(big[(1 << 21) - 1] == 7);
+    vector_free(big);
+    vector_free(w);
+    TEST_ASSERT(vector_pool_trim() == VEC_OK);
+
+    /* The rest of the spare blocks come back to this thread, none are lost */
+    void *spare[POOL_SPARE], *again[POOL_SPARE - 1], *taken;
+    int j, found;
+    pthread_create(&t, NULL, pool_spare_worker, spare);
+    pthread_join(t, NULL);
+    pthread_create(&t, NULL, pool_taker_worker, NULL);
+    pthread_join(t, &taken);
+    for (i = 0; i < POOL_SPARE - 1; i++)
+    {
+        again[i] = vector_pool_malloc(100000);
+        for (j = 0, found = 0; j < POOL_SPARE; j++)
+            found |= again[i] == spare[j] && again[i] != taken;
+        TEST_ASSERT(found);
+    }
+    for (i = 0; i < POOL_SPARE - 1; i++)
+        vector_pool_free(again[i]);
+    vector_pool_free(taken);
+    TEST_ASSERT(vector_pool_trim() == VEC_OK);
+    TEST_PASS();
+}
+
+TEST_MAKE(CompactVector)
+{
+    int *v = vector_compact(int, &a);
+    int i, x;
+    size_t len, cap;
+    TEST_ASSERT(v && vector_allocator_index(&a) == vector_allocator_index(&a));
+    TEST_ASSERT(vector_allocator_at(vector_allocator_index(&a)) == &a);
+    TEST_ASSERT(vector_compact_get_cap(v, &cap) == VEC_OK && cap == 0);
+    for (i = 0; i < 5; i++)
+        vector_compact_push_back(v, i * 10);
+    vector_compact_get_len(v, &len);
+    vector_compact_get_cap(v, &cap);
+    TEST_ASSERT(len == 5 && cap == 8 && v[4] == 40);
+    v = vector_compact_shrink_to_fit(v);
+    vector_compact_get_cap(v, &cap);
+    TEST_ASSERT(cap == 5 && v[0] == 0);
+    TEST_ASSERT(vector_compact_pop_back(v, &x) == VEC_OK && x == 40);
+    vector_compact_free(v);
+    TEST_ASSERT(vector_compact_init(1 << 16, 1, &a) == NULL);
+    TEST_PASS();
+}
+
+TEST_MAKE(CsrRoundTrip)
+{
+    int **rows = vector(int *, &a), **back;
+    int i, j, *p;
+    size_t r, len, seen = 0;
+    for (i = 0; i < 5; i++)
+    {
+        int *row = vector(int, &a);
+        for (j = 0; j < i % 3; j++) /* rows of 0, 1, 2, 0, 1 */
+            vector_push_back(row, i * 10 + j);
+        vector_push_back(rows, row);
+    }
+    vector_csr_t g;
+    TEST_ASSERT(vector_flatten_csr(rows, sizeof(int), &g) == VEC_OK);
+    TEST_ASSERT(vector_csr_rows(&g) == 5 && g.offsets[5] == 4);
+    TEST_ASSERT(vector_csr_row_len(&g, 2) == 2 && ((int *)vector_csr_row(&g, 2))[1] == 21);
+    for (r = 0; r < vector_csr_rows(&g); r++)
+        vector_csr_foreach(p, &g, r)
+        {
+            TEST_ASSERT(*p / 10 == (int)r);
+            seen++;
+        }
+    TEST_ASSERT(seen == 4);
+    TEST_ASSERT(vector_flatten_csr(rows, sizeof(double), &g) == VEC_ERR);
+
+    back = (int **)vector_unflatten_csr(&g);
+    TEST_ASSERT(back);
+    for (i = 0; i < 5; i++)
+    {
+        vector_get_len(back[i], &len);
+        TEST_ASSERT(len == (size_t)(i % 3));
+        for (j = 0; j < i % 3; j++)
+            TEST_ASSERT(back[i][j] == rows[i][j]);
+        vector_free(back[i]);
+        vector_free(rows[i]);
+    }
+    vector_free(back);
+    vector_free(rows);
+    TEST_ASSERT(vector_csr_free(&g) == VEC_OK);
+    TEST_PASS();
+}
+
+static int lifecycle_live;
+
+static void tracked_destroy(void *item)
+{
+    (void)item;
+    lifecycle_live--;
+}
+
+static void tracked_copy(void *dst, const void *src)
+{
+    *(int *)dst = *(const int *)src;
+    lifecycle_live++;
+}
+
+/* Elements hold a pointer to themselves, only a move hook keeps it right */
+typedef struct
+{
+    void *self;
+    int value;
+} self_ref_t;
+
+static void self_ref_move(void *dst, void *src)
+{
+    *(self_ref_t *)dst = *(self_ref_t *)src;
+    ((self_ref_t *)dst)->self = dst;
+}
+
+TEST_MAKE(LifecycleHooks)
+{
+    const vector_type_t tracked = {sizeof(int), tracked_destroy, tracked_copy, NULL};
+    const vector_type_t self_ref = {sizeof(self_ref_t), NULL, NULL, self_ref_move};
+    int *v = vector_init_typed(&tracked, 4, &a), *w, *raw;
+    int i;
+    size_t len;
+    TEST_ASSERT(v);
+    for (i = 0; i < 8; i++, lifecycle_live++)
+        vector_push_back(v, i);
+    TEST_ASSERT(vector_remove_ordered(v, 2) == VEC_OK && lifecycle_live == 7);
+    TEST_ASSERT(v[2] == 3 && v[6] == 7); /* the whole tail moved down */
+    v = vector_resize(v, 5);
+    TEST_ASSERT(v && lifecycle_live == 5);
+
+    /* Writing to a shared vector copies its elements with the copy hook */
+    w = vector_share(v);
+    vector_unique(w);
+    vector_remove(w, 0);
+    TEST_ASSERT(w != v && lifecycle_live == 9 && v[0] == 0 && w[0] == 1);
+    raw = vector_normal_copy(w, malloc);
+    TEST_ASSERT(raw && raw[3] == 5 && lifecycle_live == 13);
+    free(raw);
+    lifecycle_live -= 4;
+    vector_free(w);
+    vector_free(v);
+    TEST_ASSERT(lifecycle_live == 0);
+
+    /* Vectors of vectors are freed in one call, shared rows survive their first owner */
+    int **rows = vector_init_typed(&vector_type_vector, 0, &a), **copy;
+    for (i = 0; i < 3; i++)
+    {
+        int *row = vector(int, &a);
+        vector_push_back(row, i);
+        vector_push_back(rows, row);
+    }
+    copy = vector_share(rows);
+    vector_unique(copy); /* copy takes its own reference to every row */
+    vector_pop_back(copy, &w);
+    vector_free(w);
+    vector_free(rows);
+    vector_get_len(copy, &len);
+    TEST_ASSERT(len == 2 && copy[1][0] == 1);
+    vector_free(copy);
+
+    /* Sorted sets destroy the duplicates and erased elements they drop */
+    v = vector_init_typed(&tracked, 4, &a);
+    for (i = 0; i < 10; i++, lifecycle_live++)
+        vector_push_back(v, i % 4);
+    TEST_ASSERT(vector_sorted_build(v, int_cmp) == VEC_OK && lifecycle_live == 4);
+    i = 2;
+    TEST_ASSERT(vector_sorted_erase(v, &i, int_cmp) == VEC_OK && lifecycle_live == 3 && v[2] == 3);
+    vector_free(v);
+    TEST_ASSERT(lifecycle_live == 0);
+
+    /* Copies without a copy hook would release the same resources twice */
+    const vector_type_t destroy_only = {sizeof(int), tracked_destroy, NULL, NULL};
+    TEST_ASSERT(vector_init_typed(&destroy_only, 4, &a) == NULL);
+
+    self_ref_t *s = vector_init_typed(&self_ref, 1, &a), item = {NULL, 0};
+    for (i = 0; i < 20; i++)
+    {
+        vector_insert(s, 0, item);
+        s[0].self = &s[0];
+        s[0].value = i;
+    }
+    for (i = 0; i < 20; i++)
+        TEST_ASSERT(s[i].self == &s[i] && s[i].value == 19 - i);
+    vector_free(s);
+    TEST_PASS();
+}
+
+TEST_MAKE(DetachAdopt)
+{
+    int *v = vector(int, &a), *raw, *w;
+    size_t len, cap;
+    int i;
+    for (i = 0; i < 100; i++)
+        vector_push_back(v, i);
+    raw = vector_detach(v, &len);
+    TEST_ASSERT(raw && len == 100 && raw[0] == 0 && raw[99] == 99);
+
+    v = vector_adopt(raw, sizeof(int), len, 128, &a);
+    TEST_ASSERT(v && v[99] == 99);
+    vector_get_len(v, &len);
+    vector_get_cap(v, &cap);
+    TEST_ASSERT(len == 100 && cap == 128);
+    vector_push_back(v, 100);
+    TEST_ASSERT(v[100] == 100);
+    raw = malloc(2 * sizeof(int));
+    TEST_ASSERT(vector_adopt(raw, sizeof(int), 2, 1, &a) == NULL); /* buf stays with the caller on failure */
+    free(raw);
+
+    /* A shared vector gives out a copy and the other owner keeps its buffer */
+    w = vector_share(v);
+    raw = vector_detach(w, &len);
+    TEST_ASSERT(raw && raw != v && len == 101 && raw[50] == 50);
+    vector_get_refs(v, &cap);
+    TEST_ASSERT(cap == 1);
+    free(raw);
+    vector_free(v);
+    TEST_PASS();
+}
+
+TEST_MAKE(CloneConcat)
+{
+    int *v = vector(int, &a), *w = vector(int, &a), *c, *j;
+    size_t len, cap;
+    int i;
+    for (i = 0; i < 10; i++)
+        vector_push_back(v, i);
+    vector_push_back(w, 10);
+    c = vector_clone(v);
+    vector_get_len(c, &len);
+    vector_get_cap(c, &cap);
+    TEST_ASSERT(c && c != v && len == 10 && cap == 10 && c[9] == 9);
+    vector_get_refs(c, &cap);
+    TEST_ASSERT(cap == 1);
+
+    void *parts[3];
+    parts[0] = v;
+    parts[1] = w;
+    parts[2] = c;
+    j = vector_concat(parts, 3);
+    vector_get_len(j, &len);
+    vector_get_cap(j, &cap);
+    TEST_ASSERT(j && len == 21 && cap == 21 && j[10] == 10 && j[11] == 0 && j[20] == 9);
+    vector_free(j);
+
+    double *d = vector(double, &a);
+    parts[1] = d;
+    TEST_ASSERT(vector_concat(parts, 2) == NULL);
+    vector_free(d);
+
+    /* Nested vectors are shared by the clone, not moved */
+    int **rows = vector_init_typed(&vector_type_vector, 2, &a), **rc;
+    vector_push_back(rows, vector_clone(v));
+    rc = vector_clone(rows);
+    vector_free(rows);
+    TEST_ASSERT(rc[0][5] == 5);
+    vector_free(rc);
+
+    vector_free(c);
+    vector_free(w);
+    vector_free(v);
+    TEST_PASS();
+}
+
+TEST_MAKE(PipelineFused)
+{
+    int *v = vector(int, &a), *none = NULL;
+    long *squares = vector(long, &a), sum = 0;
+    size_t len, seen = 0;
+    int i;
+    for (i = 0; i < 100; i++)
+        vector_push_back(v, i);
+    vector_pipe_begin(int, x, v)
+        vector_pipe_do(seen++)
+        vector_pipe_filter(x % 2 == 0)
+        vector_pipe_map(long, sq, (long)x * x)
+        vector_pipe_take(5)
+        vector_pipe_reduce(sum, sum + sq)
+        vector_pipe_collect(squares, sq)
+    vector_pipe_end;
+    vector_get_len(squares, &len);
+    TEST_ASSERT(len == 5 && squares[4] == 64 && sum == 0 + 4 + 16 + 36 + 64);
+    TEST_ASSERT(seen == 9); /* the pass stopped at the fifth even number */
+
+    sum = 0;
+    vector_pipe_begin(int, x, none)
+        vector_pipe_reduce(sum, sum + x)
+    vector_pipe_end;
+    vector_pipe_begin(int, x, v)
+        vector_pipe_take(0)
+        vector_pipe_reduce(sum, sum + x)
+    vector_pipe_end;
+    TEST_ASSERT(sum == 0);
+    vector_free(squares);
+    vector_free(v);
+    TEST_PASS();
+}
+
+TEST_MAKE(ForeachRef)
+{
+    int *v = vector(int, &a), *p, *end, *none = NULL;
+    int **rows = vector(int *, &a), **row, **rows_end;
+    int i, sum = 0;
+    for (i = 0; i < 20; i++)
+        vector_push_back(v, i);
+    vector_foreach_ref(p, end, v)
+        *p *= 2;
+    TEST_ASSERT(v[19] == 38 && end == v + 20);
+    vector_foreach_ref(p, end, none)
+        sum++;
+    TEST_ASSERT(sum == 0);
+
+    for (i = 0; i < 20; i++)
+    {
+        int *r = vector(int, &a);
+        vector_push_back(r, i);
+        vector_push_back(rows, r);
+    }
+    vector_foreach_ref_prefetch(row, rows_end, rows, VECTOR_PREFETCH_DISTANCE)
+    {
+        sum += (*row)[0];
+        vector_free(*row);
+    }
+    TEST_ASSERT(sum == 190);
+    vector_free(rows);
+    vector_free(v);
+    TEST_PASS();
+}
+
 TEST_SUITE(Vector,
 {
     TEST_SUITE_LINK(Vector,InitFree);
     TEST_SUITE_LINK(Vector,Append);
     TEST_SUITE_LINK(Vector,PopBack);
+    TEST_SUITE_LINK(Vector,CopyOnWrite);
+    TEST_SUITE_LINK(Vector,DequeFifo);
+    TEST_SUITE_LINK(Vector,DequeLinearize);
+    TEST_SUITE_LINK(Vector,SpscBatch);
+    TEST_SUITE_LINK(Vector,MpmcBatch);
+    TEST_SUITE_LINK(Vector,AppendConcurrentSeal);
+    TEST_SUITE_LINK(Vector,CombinableMerge);
+    TEST_SUITE_LINK(Vector,ParallelForMapReduce);
+    TEST_SUITE_LINK(Vector,SchedulerSplit);
+    TEST_SUITE_LINK(Vector,ParallelSort);
+    TEST_SUITE_LINK(Vector,RrbVersions);
+    TEST_SUITE_LINK(Vector,SoaColumns);
+    TEST_SUITE_LINK(Vector,BitsOps);
+    TEST_SUITE_LINK(Vector,BitsRankSelect);
+    TEST_SUITE_LINK(Vector,SortedSet);
+    TEST_SUITE_LINK(Vector,EytzingerSearch);
+    TEST_SUITE_LINK(Vector,HashMap);
+    TEST_SUITE_LINK(Vector,HeapOrder);
+    TEST_SUITE_LINK(Vector,PoolRecycle);
+    TEST_SUITE_LINK(Vector,CompactVector);
+    TEST_SUITE_LINK(Vector,CsrRoundTrip);
+    TEST_SUITE_LINK(Vector,LifecycleHooks);
+    TEST_SUITE_LINK(Vector,DetachAdopt);
+    TEST_SUITE_LINK(Vector,CloneConcat);
+    TEST_SUITE_LINK(Vector,PipelineFused);
+    TEST_SUITE_LINK(Vector,ForeachRef);
 })
 
 int main(int argc, char** argv)